@@ -0,0 +1,279 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск A* с оценками по ориентирам (ALT). Для каждого ориентира L заранее известны
+// расстояния d(L, v) и d(v, L); по неравенству треугольника d(v, t) не меньше
+// d(L, t) - d(L, v) и d(v, L) - d(t, L). Такая оценка допустима и согласована, поэтому
+// запрос — это Дейкстра по приведённым весам и просматривает лишь вершины около пути.
+template <typename Weight>
+class AltRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Scratch = detail::SearchScratch<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    // Расстояния хранятся по вершинам: from_landmarks[v * count + l] = d(L_l, v),
+    // to_landmarks[v * count + l] = d(v, L_l); недостижимость — бесконечный вес
+    struct Landmarks {
+        std::vector<VertexId> vertices;
+        std::vector<Weight> from_landmarks;
+        std::vector<Weight> to_landmarks;
+    };
+
+    AltRouter(const Graph& graph, size_t landmarks_count);
+    AltRouter(const Graph& graph, Landmarks landmarks);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Поиск A* в рабочей памяти потока, как у DijkstraRouter
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Только веса маршрутов из from во все targets. Оценка по ориентирам ведёт к одной цели,
+    // поэтому здесь один обычный поиск Дейкстры на все цели
+    void GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                         std::vector<std::optional<Weight>>& weights) const;
+    const Landmarks& GetLandmarks() const;
+
+private:
+    static_assert(std::numeric_limits<Weight>::has_infinity, "AltRouter needs a weight type with infinity");
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+    static constexpr Weight ZERO_WEIGHT{};
+
+    std::vector<Weight> ComputeDistances(VertexId source, bool reverse) const;
+    void SelectLandmarks(size_t landmarks_count);
+    Weight GetPotential(VertexId vertex, const Weight* target_from, const Weight* target_to) const;
+
+    const Graph& graph_;
+    Landmarks landmarks_;
+    // Обратные списки смежности нужны только для расстояний до ориентиров
+    std::vector<size_t> reverse_offsets_;
+    std::vector<EdgeId> reverse_edges_;
+};
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmarks_count)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    const size_t vertex_count = graph.GetVertexCount();
+    reverse_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        ++reverse_offsets_[graph.GetEdge(edge_id).to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+    }
+    reverse_edges_.resize(graph.GetEdgeCount());
+    std::vector<size_t> next(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        reverse_edges_[next[graph.GetEdge(edge_id).to]++] = edge_id;
+    }
+
+    SelectLandmarks(std::min(landmarks_count, vertex_count));
+
+    // Обратные списки больше не нужны: запросы идут только вперёд
+    std::vector<size_t>().swap(reverse_offsets_);
+    std::vector<EdgeId>().swap(reverse_edges_);
+}
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, Landmarks landmarks)
+    : graph_(graph)
+    , landmarks_(std::move(landmarks))
+{
+    const size_t cells_count = graph.GetVertexCount() * landmarks_.vertices.size();
+    if (landmarks_.from_landmarks.size() != cells_count || landmarks_.to_landmarks.size() != cells_count) {
+        throw std::invalid_argument("Landmarks do not match the graph");
+    }
+}
+
+template <typename Weight>
+std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId source, bool reverse) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Scratch scratch;
+    scratch.Reset(vertex_count);
+    scratch.Relax(source, ZERO_WEIGHT, 0);
+    while (const auto item = scratch.PopSettled()) {
+        const auto [weight, vertex] = *item;
+        if (reverse) {
+            for (size_t index = reverse_offsets_[vertex]; index < reverse_offsets_[vertex + 1]; ++index) {
+                const auto edge = graph_.GetEdge(reverse_edges_[index]);
+                scratch.Relax(edge.from, weight + edge.weight, reverse_edges_[index]);
+            }
+        }
+        else {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto edge = graph_.GetEdge(edge_id);
+                scratch.Relax(edge.to, weight + edge.weight, edge_id);
+            }
+        }
+    }
+
+    std::vector<Weight> distances(vertex_count, INFINITE_WEIGHT);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (scratch.IsReached(vertex)) {
+            distances[vertex] = scratch.GetWeight(vertex);
+        }
+    }
+    return distances;
+}
+
+template <typename Weight>
+void AltRouter<Weight>::SelectLandmarks(size_t landmarks_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<std::vector<Weight>> from_landmarks;
+    std::vector<std::vector<Weight>> to_landmarks;
+
+    // Выбор «самой дальней»: очередной ориентир — вершина, у которой наибольшее расстояние
+    // до ближайшего из уже выбранных. Поиск начинается от вершины с наибольшим числом рёбер,
+    // она почти наверняка в основной компоненте; вершины, не связанные с ориентирами,
+    // не выбираются: ориентир в отдельной остановке не даёт оценок для остальной сети.
+    std::vector<size_t> degrees(vertex_count, 0);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto edge = graph_.GetEdge(edge_id);
+        ++degrees[edge.from];
+        ++degrees[edge.to];
+    }
+    const VertexId start = vertex_count == 0 ? 0
+        : static_cast<VertexId>(std::max_element(degrees.begin(), degrees.end()) - degrees.begin());
+    std::vector<Weight> separation(vertex_count, ZERO_WEIGHT);
+    if (landmarks_count > 0) {
+        const std::vector<Weight> distances = ComputeDistances(start, false);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            separation[vertex] = distances[vertex] == INFINITE_WEIGHT ? ZERO_WEIGHT : distances[vertex];
+        }
+    }
+    while (landmarks_.vertices.size() < landmarks_count) {
+        const VertexId landmark = static_cast<VertexId>(
+            std::max_element(separation.begin(), separation.end()) - separation.begin());
+        landmarks_.vertices.push_back(landmark);
+        from_landmarks.push_back(ComputeDistances(landmark, false));
+        to_landmarks.push_back(ComputeDistances(landmark, true));
+
+        const bool is_first = landmarks_.vertices.size() == 1;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const Weight forward = from_landmarks.back()[vertex];
+            const Weight backward = to_landmarks.back()[vertex];
+            const Weight distance = (forward == INFINITE_WEIGHT ? ZERO_WEIGHT : forward)
+                + (backward == INFINITE_WEIGHT ? ZERO_WEIGHT : backward);
+            separation[vertex] = is_first ? distance : std::min(separation[vertex], distance);
+        }
+        separation[landmark] = -INFINITE_WEIGHT;
+    }
+
+    const size_t count = landmarks_.vertices.size();
+    landmarks_.from_landmarks.assign(vertex_count * count, INFINITE_WEIGHT);
+    landmarks_.to_landmarks.assign(vertex_count * count, INFINITE_WEIGHT);
+    for (size_t landmark = 0; landmark < count; ++landmark) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            landmarks_.from_landmarks[vertex * count + landmark] = from_landmarks[landmark][vertex];
+            landmarks_.to_landmarks[vertex * count + landmark] = to_landmarks[landmark][vertex];
+        }
+    }
+}
+
+template <typename Weight>
+Weight AltRouter<Weight>::GetPotential(VertexId vertex, const Weight* target_from, const Weight* target_to) const {
+    const size_t count = landmarks_.vertices.size();
+    const Weight* vertex_from = landmarks_.from_landmarks.data() + vertex * count;
+    const Weight* vertex_to = landmarks_.to_landmarks.data() + vertex * count;
+    Weight potential = ZERO_WEIGHT;
+    for (size_t landmark = 0; landmark < count; ++landmark) {
+        // Слагаемое с бесконечностью ничего не говорит о расстоянии и пропускается
+        if (target_from[landmark] != INFINITE_WEIGHT && vertex_from[landmark] != INFINITE_WEIGHT) {
+            potential = std::max(potential, target_from[landmark] - vertex_from[landmark]);
+        }
+        if (vertex_to[landmark] != INFINITE_WEIGHT && target_to[landmark] != INFINITE_WEIGHT) {
+            potential = std::max(potential, vertex_to[landmark] - target_to[landmark]);
+        }
+    }
+    return potential;
+}
+
+template <typename Weight>
+std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const std::optional<Weight> weight = BuildRoute(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> AltRouter<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const size_t count = landmarks_.vertices.size();
+    const Weight* target_from = landmarks_.from_landmarks.data() + to * count;
+    const Weight* target_to = landmarks_.to_landmarks.data() + to * count;
+
+    // Поиск идёт по приведённым весам w(u, v) + p(v) - p(u); из-за округления они могут
+    // стать чуть меньше нуля, поэтому обрезаются. Вес маршрута затем считается по рёбрам.
+    static thread_local Scratch scratch;
+    scratch.Reset(vertex_count);
+    scratch.Relax(from, ZERO_WEIGHT, 0);
+    while (const auto item = scratch.PopSettled()) {
+        const auto [reduced_weight, vertex] = *item;
+        if (vertex == to) {
+            break;
+        }
+        const Weight potential = GetPotential(vertex, target_from, target_to);
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const Weight reduced_edge_weight = edge.weight + GetPotential(edge.to, target_from, target_to) - potential;
+            scratch.Relax(edge.to, reduced_weight + std::max(reduced_edge_weight, ZERO_WEIGHT), edge_id);
+        }
+    }
+
+    edges.clear();
+    if (!scratch.IsReached(to)) {
+        return std::nullopt;
+    }
+    for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(scratch.GetPrevId(vertex)).from) {
+        edges.push_back(scratch.GetPrevId(vertex));
+    }
+    std::reverse(edges.begin(), edges.end());
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+
+    return weight;
+}
+
+template <typename Weight>
+void AltRouter<Weight>::GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                                        std::vector<std::optional<Weight>>& weights) const {
+    static thread_local Scratch scratch;
+    detail::SearchTargets(graph_, from, targets, scratch);
+    weights.clear();
+    for (const VertexId target : targets) {
+        weights.push_back(scratch.IsReached(target) ? std::optional<Weight>(scratch.GetWeight(target)) : std::nullopt);
+    }
+}
+
+template <typename Weight>
+const typename AltRouter<Weight>::Landmarks& AltRouter<Weight>::GetLandmarks() const {
+    return landmarks_;
+}
+
+}  // namespace graph
@@ -0,0 +1,520 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сокращений (Contraction Hierarchies). Вершины стягиваются по порядку
+// важности, сохраняющие кратчайшие пути сокращения добавляются в граф. Запрос —
+// двунаправленный поиск только «вверх» по рангу с распаковкой сокращений.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Scratch = detail::SearchScratch<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    using ArcId = size_t;
+    static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+
+    // Дуга иерархии: либо исходное ребро графа, либо сокращение из двух дуг first и second
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId edge_id = 0;
+        ArcId first = NO_ARC;
+        ArcId second = NO_ARC;
+
+        bool IsShortcut() const {
+            return first != NO_ARC;
+        }
+    };
+
+    struct Index {
+        std::vector<size_t> ranks;
+        std::vector<Arc> arcs;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    ContractionHierarchy(const Graph& graph, Index index);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Дуги иерархии распаковываются в edges через буферы потока
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Маршруты из одной вершины во все targets: поиск вверх от from выполняется один раз
+    // целиком, для каждой цели остаётся только обратный поиск
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+    // То же в буферы batch, которые очищаются перед записью
+    void BuildRoutes(VertexId from, const std::vector<VertexId>& targets, RouteBatch<Weight>& batch) const;
+    // Только веса: те же поиски, что у BuildRoutes, но без распаковки сокращений
+    void GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                         std::vector<std::optional<Weight>>& weights) const;
+    const Index& GetIndex() const;
+
+private:
+    // Предел осмотренных вершин в поиске свидетеля: при его исчерпании
+    // сокращение добавляется без проверки, что не нарушает корректность
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+
+    struct Contraction {
+        std::vector<std::vector<ArcId>> in_arcs;
+        std::vector<std::vector<ArcId>> out_arcs;
+        std::vector<bool> contracted;
+        std::vector<int> contracted_neighbours;
+        Scratch witness_scratch;
+    };
+
+    void Contract();
+    void InitializeArcs(Contraction& contraction);
+    std::vector<Arc> FindShortcuts(Contraction& contraction, VertexId vertex) const;
+    std::vector<ArcId> GetBestArcs(const Contraction& contraction, const std::vector<ArcId>& arc_ids,
+                                   VertexId vertex, bool outgoing) const;
+    int ComputePriority(Contraction& contraction, VertexId vertex) const;
+    void ContractVertex(Contraction& contraction, VertexId vertex);
+    void BuildSearchGraphs();
+    // Поиск вверх от from целиком, один на все цели пачки
+    void SearchUp(VertexId from, Scratch& forward) const;
+    // Обратный поиск вниз от to до встречи с деревом forward; meeting_vertex — вершина встречи
+    std::optional<Weight> SearchDown(const Scratch& forward, VertexId to, Scratch& backward,
+                                     VertexId& meeting_vertex) const;
+    void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+    void UnpackPath(const Scratch& forward, const Scratch& backward,
+                    VertexId from, VertexId meeting_vertex, VertexId to, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Index index_;
+    std::vector<std::vector<ArcId>> up_arcs_;
+    std::vector<std::vector<ArcId>> down_arcs_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    Contract();
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, Index index)
+    : graph_(graph)
+    , index_(std::move(index))
+{
+    if (index_.ranks.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Contraction hierarchy does not match the graph");
+    }
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+const typename ContractionHierarchy<Weight>::Index& ContractionHierarchy<Weight>::GetIndex() const {
+    return index_;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::InitializeArcs(Contraction& contraction) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    // Из параллельных рёбер в иерархию попадает самое лёгкое
+    std::vector<EdgeId> best_edges;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        best_edges.clear();
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.to != vertex) {
+                best_edges.push_back(edge_id);
+            }
+        }
+        std::sort(best_edges.begin(), best_edges.end(), [this](EdgeId lhs, EdgeId rhs) {
+            const auto& lhs_edge = graph_.GetEdge(lhs);
+            const auto& rhs_edge = graph_.GetEdge(rhs);
+            if (lhs_edge.to != rhs_edge.to) {
+                return lhs_edge.to < rhs_edge.to;
+            }
+            if (lhs_edge.weight != rhs_edge.weight) {
+                return lhs_edge.weight < rhs_edge.weight;
+            }
+            return lhs < rhs;
+        });
+        for (size_t i = 0; i < best_edges.size(); ++i) {
+            const auto& edge = graph_.GetEdge(best_edges[i]);
+            if (i > 0 && graph_.GetEdge(best_edges[i - 1]).to == edge.to) {
+                continue;
+            }
+            const ArcId arc_id = index_.arcs.size();
+            index_.arcs.push_back({edge.from, edge.to, edge.weight, best_edges[i]});
+            contraction.out_arcs[edge.from].push_back(arc_id);
+            contraction.in_arcs[edge.to].push_back(arc_id);
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::ArcId> ContractionHierarchy<Weight>::GetBestArcs(
+        const Contraction& contraction, const std::vector<ArcId>& arc_ids, VertexId vertex, bool outgoing) const {
+    std::vector<ArcId> result;
+    for (const ArcId arc_id : arc_ids) {
+        const Arc& arc = index_.arcs[arc_id];
+        const VertexId neighbour = outgoing ? arc.to : arc.from;
+        if (neighbour != vertex && !contraction.contracted[neighbour]) {
+            result.push_back(arc_id);
+        }
+    }
+    std::sort(result.begin(), result.end(), [this, outgoing](ArcId lhs, ArcId rhs) {
+        const Arc& lhs_arc = index_.arcs[lhs];
+        const Arc& rhs_arc = index_.arcs[rhs];
+        const VertexId lhs_neighbour = outgoing ? lhs_arc.to : lhs_arc.from;
+        const VertexId rhs_neighbour = outgoing ? rhs_arc.to : rhs_arc.from;
+        if (lhs_neighbour != rhs_neighbour) {
+            return lhs_neighbour < rhs_neighbour;
+        }
+        if (lhs_arc.weight != rhs_arc.weight) {
+            return lhs_arc.weight < rhs_arc.weight;
+        }
+        return lhs < rhs;
+    });
+    result.erase(std::unique(result.begin(), result.end(), [this, outgoing](ArcId lhs, ArcId rhs) {
+        return outgoing ? index_.arcs[lhs].to == index_.arcs[rhs].to
+                        : index_.arcs[lhs].from == index_.arcs[rhs].from;
+    }), result.end());
+    return result;
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::Arc> ContractionHierarchy<Weight>::FindShortcuts(
+        Contraction& contraction, VertexId vertex) const {
+    std::vector<Arc> shortcuts;
+    const auto in_arcs = GetBestArcs(contraction, contraction.in_arcs[vertex], vertex, false);
+    const auto out_arcs = GetBestArcs(contraction, contraction.out_arcs[vertex], vertex, true);
+    if (in_arcs.empty() || out_arcs.empty()) {
+        return shortcuts;
+    }
+    Weight max_out_weight = ZERO_WEIGHT;
+    for (const ArcId arc_id : out_arcs) {
+        max_out_weight = std::max(max_out_weight, index_.arcs[arc_id].weight);
+    }
+
+    Scratch& scratch = contraction.witness_scratch;
+    for (const ArcId in_arc_id : in_arcs) {
+        const Arc& in_arc = index_.arcs[in_arc_id];
+        const VertexId source = in_arc.from;
+        const Weight max_weight = in_arc.weight + max_out_weight;
+
+        // Поиск свидетеля: путь из source в обход vertex не длиннее сокращения
+        scratch.Reset(graph_.GetVertexCount());
+        scratch.Relax(source, ZERO_WEIGHT, NO_ARC);
+        size_t settled_count = 0;
+        while (const auto item = scratch.PopSettled()) {
+            const auto [weight, current] = *item;
+            if (max_weight < weight || ++settled_count > WITNESS_SETTLED_LIMIT) {
+                break;
+            }
+            for (const ArcId arc_id : contraction.out_arcs[current]) {
+                const Arc& arc = index_.arcs[arc_id];
+                if (arc.to != vertex && !contraction.contracted[arc.to]) {
+                    scratch.Relax(arc.to, weight + arc.weight, arc_id);
+                }
+            }
+        }
+
+        for (const ArcId out_arc_id : out_arcs) {
+            const Arc& out_arc = index_.arcs[out_arc_id];
+            if (out_arc.to == source) {
+                continue;
+            }
+            const Weight via_weight = in_arc.weight + out_arc.weight;
+            if (!scratch.IsReached(out_arc.to) || via_weight < scratch.GetWeight(out_arc.to)) {
+                shortcuts.push_back({source, out_arc.to, via_weight, 0, in_arc_id, out_arc_id});
+            }
+        }
+    }
+    return shortcuts;
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::ComputePriority(Contraction& contraction, VertexId vertex) const {
+    // Разность рёбер: сколько сокращений добавится против числа удаляемых дуг
+    const int shortcuts_count = static_cast<int>(FindShortcuts(contraction, vertex).size());
+    const int removed_count = static_cast<int>(contraction.in_arcs[vertex].size() + contraction.out_arcs[vertex].size());
+    return shortcuts_count - removed_count + contraction.contracted_neighbours[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractVertex(Contraction& contraction, VertexId vertex) {
+    for (Arc& shortcut : FindShortcuts(contraction, vertex)) {
+        const ArcId arc_id = index_.arcs.size();
+        contraction.out_arcs[shortcut.from].push_back(arc_id);
+        contraction.in_arcs[shortcut.to].push_back(arc_id);
+        index_.arcs.push_back(std::move(shortcut));
+    }
+    contraction.contracted[vertex] = true;
+    for (const ArcId arc_id : contraction.in_arcs[vertex]) {
+        ++contraction.contracted_neighbours[index_.arcs[arc_id].from];
+    }
+    for (const ArcId arc_id : contraction.out_arcs[vertex]) {
+        ++contraction.contracted_neighbours[index_.arcs[arc_id].to];
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Contraction contraction{
+        std::vector<std::vector<ArcId>>(vertex_count),
+        std::vector<std::vector<ArcId>>(vertex_count),
+        std::vector<bool>(vertex_count, false),
+        std::vector<int>(vertex_count, 0),
+        {}
+    };
+    InitializeArcs(contraction);
+
+    // Ленивая очередь: приоритет извлечённой вершины пересчитывается,
+    // и если он стал хуже следующего, вершина возвращается в очередь
+    using QueueItem = std::pair<int, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.emplace(ComputePriority(contraction, vertex), vertex);
+    }
+
+    index_.ranks.assign(vertex_count, 0);
+    size_t rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        const int priority = ComputePriority(contraction, vertex);
+        if (!queue.empty() && queue.top().first < priority) {
+            queue.emplace(priority, vertex);
+            continue;
+        }
+        ContractVertex(contraction, vertex);
+        index_.ranks[vertex] = rank++;
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraphs() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    up_arcs_.assign(vertex_count, {});
+    down_arcs_.assign(vertex_count, {});
+    for (ArcId arc_id = 0; arc_id < index_.arcs.size(); ++arc_id) {
+        const Arc& arc = index_.arcs[arc_id];
+        if (index_.ranks[arc.from] < index_.ranks[arc.to]) {
+            up_arcs_[arc.from].push_back(arc_id);
+        }
+        else {
+            down_arcs_[arc.to].push_back(arc_id);
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+    static thread_local std::vector<ArcId> stack;
+    stack.assign(1, arc_id);
+    while (!stack.empty()) {
+        const Arc& arc = index_.arcs[stack.back()];
+        stack.pop_back();
+        if (arc.IsShortcut()) {
+            stack.push_back(arc.second);
+            stack.push_back(arc.first);
+        }
+        else {
+            edges.push_back(arc.edge_id);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(
+        VertexId from, VertexId to) const {
+    std::vector<EdgeId> edges;
+    const std::optional<Weight> weight = BuildRoute(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                               std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    static thread_local Scratch forward;
+    static thread_local Scratch backward;
+    forward.Reset(vertex_count);
+    backward.Reset(vertex_count);
+    forward.Relax(from, ZERO_WEIGHT, NO_ARC);
+    backward.Relax(to, ZERO_WEIGHT, NO_ARC);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (forward.IsReached(vertex) && backward.IsReached(vertex)) {
+            const Weight weight = forward.GetWeight(vertex) + backward.GetWeight(vertex);
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = vertex;
+            }
+        }
+    };
+    const auto is_exhausted = [&best_weight](const Scratch& scratch) {
+        return scratch.IsQueueEmpty() || (best_weight && !(scratch.Top().first < *best_weight));
+    };
+
+    while (!is_exhausted(forward) || !is_exhausted(backward)) {
+        const bool forward_step = !is_exhausted(forward)
+            && (is_exhausted(backward) || !(backward.Top().first < forward.Top().first));
+        Scratch& scratch = forward_step ? forward : backward;
+        const auto item = scratch.PopSettled();
+        if (!item) {
+            continue;
+        }
+        const auto [weight, vertex] = *item;
+        update_best(vertex);
+        const auto& arcs = forward_step ? up_arcs_[vertex] : down_arcs_[vertex];
+        for (const ArcId arc_id : arcs) {
+            const Arc& arc = index_.arcs[arc_id];
+            const VertexId next = forward_step ? arc.to : arc.from;
+            if (scratch.Relax(next, weight + arc.weight, arc_id)) {
+                update_best(next);
+            }
+        }
+    }
+
+    edges.clear();
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    UnpackPath(forward, backward, from, meeting_vertex, to, edges);
+    return best_weight;
+}
+
+template <typename Weight>
+std::vector<std::optional<typename ContractionHierarchy<Weight>::RouteInfo>> ContractionHierarchy<Weight>::BuildRoutes(
+        VertexId from, const std::vector<VertexId>& targets) const {
+    RouteBatch<Weight> batch;
+    BuildRoutes(from, targets, batch);
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (size_t k = 0; k < targets.size(); ++k) {
+        routes.push_back(batch.GetRoute(k));
+    }
+    return routes;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& targets,
+                                               RouteBatch<Weight>& batch) const {
+    static thread_local Scratch forward;
+    static thread_local Scratch backward;
+    SearchUp(from, forward);
+    batch.Clear();
+    for (const VertexId to : targets) {
+        VertexId meeting_vertex = to;
+        const std::optional<Weight> weight = SearchDown(forward, to, backward, meeting_vertex);
+        if (weight) {
+            UnpackPath(forward, backward, from, meeting_vertex, to, batch.edges);
+        }
+        batch.AddRoute(weight);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                                                   std::vector<std::optional<Weight>>& weights) const {
+    static thread_local Scratch forward;
+    static thread_local Scratch backward;
+    SearchUp(from, forward);
+    weights.clear();
+    for (const VertexId to : targets) {
+        VertexId meeting_vertex = to;
+        weights.push_back(SearchDown(forward, to, backward, meeting_vertex));
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::SearchUp(VertexId from, Scratch& forward) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    forward.Reset(vertex_count);
+    forward.Relax(from, ZERO_WEIGHT, NO_ARC);
+    while (const auto item = forward.PopSettled()) {
+        const auto [weight, vertex] = *item;
+        for (const ArcId arc_id : up_arcs_[vertex]) {
+            const Arc& arc = index_.arcs[arc_id];
+            forward.Relax(arc.to, weight + arc.weight, arc_id);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<Weight> ContractionHierarchy<Weight>::SearchDown(const Scratch& forward, VertexId to, Scratch& backward,
+                                                               VertexId& meeting_vertex) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    backward.Reset(vertex_count);
+    backward.Relax(to, ZERO_WEIGHT, NO_ARC);
+    std::optional<Weight> best_weight;
+    while (!backward.IsQueueEmpty() && !(best_weight && !(backward.Top().first < *best_weight))) {
+        const auto item = backward.PopSettled();
+        if (!item) {
+            break;
+        }
+        const auto [weight, vertex] = *item;
+        if (forward.IsReached(vertex)) {
+            const Weight route_weight = forward.GetWeight(vertex) + weight;
+            if (!best_weight || route_weight < *best_weight) {
+                best_weight = route_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        for (const ArcId arc_id : down_arcs_[vertex]) {
+            const Arc& arc = index_.arcs[arc_id];
+            backward.Relax(arc.from, weight + arc.weight, arc_id);
+        }
+    }
+    return best_weight;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackPath(const Scratch& forward, const Scratch& backward, VertexId from,
+                                              VertexId meeting_vertex, VertexId to, std::vector<EdgeId>& edges) const {
+    static thread_local std::vector<ArcId> forward_arcs;
+    forward_arcs.clear();
+    for (VertexId vertex = meeting_vertex; vertex != from; vertex = index_.arcs[forward.GetPrevId(vertex)].from) {
+        forward_arcs.push_back(forward.GetPrevId(vertex));
+    }
+    for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); ++it) {
+        UnpackArc(*it, edges);
+    }
+    for (VertexId vertex = meeting_vertex; vertex != to; vertex = index_.arcs[backward.GetPrevId(vertex)].to) {
+        UnpackArc(backward.GetPrevId(vertex), edges);
+    }
+}
+
+}  // namespace graph
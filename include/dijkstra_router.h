@@ -0,0 +1,335 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+namespace detail {
+
+// Буферы поиска по графу переиспользуются между запросами. Метка поколения
+// отличает вершины текущего поиска, поэтому массивы не очищаются.
+template <typename Weight>
+class SearchScratch {
+public:
+    using HeapItem = std::pair<Weight, VertexId>;
+
+    void Reset(size_t vertex_count) {
+        if (stamps_.size() < vertex_count) {
+            weights_.resize(vertex_count);
+            prev_ids_.resize(vertex_count);
+            stamps_.resize(vertex_count, 0);
+        }
+        if (++stamp_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            stamp_ = 1;
+        }
+        heap_.clear();
+    }
+
+    bool IsReached(VertexId vertex) const {
+        return stamps_[vertex] == stamp_;
+    }
+
+    Weight GetWeight(VertexId vertex) const {
+        return weights_[vertex];
+    }
+
+    size_t GetPrevId(VertexId vertex) const {
+        return prev_ids_[vertex];
+    }
+
+    // Улучшает оценку вершины и ставит её в очередь; prev_id — ребро или дуга, которой она достигнута
+    bool Relax(VertexId vertex, Weight weight, size_t prev_id) {
+        if (IsReached(vertex) && !(weight < weights_[vertex])) {
+            return false;
+        }
+        weights_[vertex] = weight;
+        prev_ids_[vertex] = prev_id;
+        stamps_[vertex] = stamp_;
+        heap_.emplace_back(weight, vertex);
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapItem>{});
+        return true;
+    }
+
+    bool IsQueueEmpty() const {
+        return heap_.empty();
+    }
+
+    const HeapItem& Top() const {
+        return heap_.front();
+    }
+
+    // Извлекает ближайшую вершину, пропуская устаревшие записи очереди
+    std::optional<HeapItem> PopSettled() {
+        while (!heap_.empty()) {
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapItem>{});
+            const HeapItem item = heap_.back();
+            heap_.pop_back();
+            if (!(weights_[item.second] < item.first)) {
+                return item;
+            }
+        }
+        return std::nullopt;
+    }
+
+private:
+    std::vector<Weight> weights_;
+    std::vector<size_t> prev_ids_;
+    std::vector<uint32_t> stamps_;
+    std::vector<HeapItem> heap_;
+    uint32_t stamp_ = 0;
+};
+
+// Дейкстра из from, пока не осмотрены все targets или не кончилась очередь.
+// Веса и предки достигнутых вершин остаются в scratch
+template <typename Weight>
+void SearchTargets(const DirectedWeightedGraph<Weight>& graph, VertexId from, const std::vector<VertexId>& targets,
+                   SearchScratch<Weight>& scratch) {
+    const size_t vertex_count = graph.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    static thread_local std::vector<VertexId> pending;
+    pending.assign(targets.begin(), targets.end());
+    for (const VertexId target : pending) {
+        if (target >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+    scratch.Reset(vertex_count);
+    scratch.Relax(from, Weight{}, 0);
+    size_t pending_count = pending.size();
+    while (pending_count > 0) {
+        const auto item = scratch.PopSettled();
+        if (!item) {
+            break;
+        }
+        const auto [weight, vertex] = *item;
+        if (std::binary_search(pending.begin(), pending.end(), vertex)) {
+            --pending_count;
+        }
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            scratch.Relax(edge.to, weight + edge.weight, edge_id);
+        }
+    }
+}
+
+}  // namespace detail
+
+// Маршруты из одной вершины в несколько целей в буферах, которые переиспользуются между
+// вызовами: рёбра маршрута k — edges[offsets[k], offsets[k + 1]), weights[k] пуст, если цель
+// недостижима. Очистка сохраняет ёмкость, поэтому повторные пачки не выделяют память
+template <typename Weight>
+struct RouteBatch {
+    std::vector<std::optional<Weight>> weights;
+    std::vector<size_t> offsets;
+    std::vector<EdgeId> edges;
+
+    void Clear() {
+        weights.clear();
+        offsets.assign(1, 0);
+        edges.clear();
+    }
+
+    // Закрывает маршрут очередной цели: его рёбра уже дописаны в edges
+    void AddRoute(std::optional<Weight> weight) {
+        weights.push_back(weight);
+        offsets.push_back(edges.size());
+    }
+
+    ranges::Range<const EdgeId*> GetEdges(size_t index) const {
+        return { edges.data() + offsets[index], edges.data() + offsets[index + 1] };
+    }
+
+    // Копия маршрута k для тех, кому нужен отдельный RouteInfo
+    std::optional<typename Router<Weight>::RouteInfo> GetRoute(size_t index) const {
+        if (!weights[index]) {
+            return std::nullopt;
+        }
+        const auto route_edges = GetEdges(index);
+        return typename Router<Weight>::RouteInfo{*weights[index], {route_edges.begin(), route_edges.end()}};
+    }
+};
+
+// Маршрутизатор без предрасчёта: каждый запрос решается алгоритмом Дейкстры
+// на бинарной куче. Память линейна по размеру графа, в отличие от таблицы Router.
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Scratch = detail::SearchScratch<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Поиск идёт в рабочей памяти потока, рёбра восстанавливаются с конца и разворачиваются
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Маршруты из одной вершины во все targets за один проход: поиск останавливается,
+    // когда достигнуты все цели, пути восстанавливаются по общему массиву предков
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+    // То же в буферы batch, которые очищаются перед записью
+    void BuildRoutes(VertexId from, const std::vector<VertexId>& targets, RouteBatch<Weight>& batch) const;
+    // Только веса маршрутов из from во все targets, пути не восстанавливаются
+    void GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                         std::vector<std::optional<Weight>>& weights) const;
+
+private:
+    // Дописывает в edges рёбра пути до to из дерева поиска
+    std::optional<Weight> ReconstructRoute(const Scratch& scratch, VertexId from, VertexId to,
+                                           std::vector<EdgeId>& edges) const;
+
+    // Свой набор буферов на каждый поток, чтобы const-запросы оставались потокобезопасными
+    static Scratch& PrepareScratch(size_t vertex_count) {
+        static thread_local Scratch scratch;
+        scratch.Reset(vertex_count);
+        return scratch;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+};
+
+// Вершины, достижимые из from не дольше max_weight, с весами в порядке их возрастания.
+// Поиск обрывается на границе: дальние вершины не попадают даже в очередь
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> FindVerticesWithin(const DirectedWeightedGraph<Weight>& graph, VertexId from,
+                                                            Weight max_weight) {
+    const size_t vertex_count = graph.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    static thread_local detail::SearchScratch<Weight> scratch;
+    scratch.Reset(vertex_count);
+    std::vector<std::pair<VertexId, Weight>> reached;
+    if (max_weight < Weight{}) {
+        return reached;
+    }
+    scratch.Relax(from, Weight{}, 0);
+    while (const auto item = scratch.PopSettled()) {
+        const auto [weight, vertex] = *item;
+        reached.emplace_back(vertex, weight);
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            const Weight edge_end_weight = weight + edge.weight;
+            if (!(max_weight < edge_end_weight)) {
+                scratch.Relax(edge.to, edge_end_weight, edge_id);
+            }
+        }
+    }
+    return reached;
+}
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    std::vector<EdgeId> edges;
+    const std::optional<Weight> weight = BuildRoute(from, to, edges);
+    if (!weight) {
+        return std::nullopt;
+    }
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    Scratch& scratch = PrepareScratch(vertex_count);
+    scratch.Relax(from, ZERO_WEIGHT, 0);
+    while (const auto item = scratch.PopSettled()) {
+        const auto [weight, vertex] = *item;
+        if (vertex == to) {
+            break;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            scratch.Relax(edge.to, weight + edge.weight, edge_id);
+        }
+    }
+
+    edges.clear();
+    return ReconstructRoute(scratch, from, to, edges);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+        VertexId from, const std::vector<VertexId>& targets) const {
+    RouteBatch<Weight> batch;
+    BuildRoutes(from, targets, batch);
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (size_t k = 0; k < targets.size(); ++k) {
+        routes.push_back(batch.GetRoute(k));
+    }
+    return routes;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::BuildRoutes(VertexId from, const std::vector<VertexId>& targets,
+                                         RouteBatch<Weight>& batch) const {
+    Scratch& scratch = PrepareScratch(graph_.GetVertexCount());
+    detail::SearchTargets(graph_, from, targets, scratch);
+    batch.Clear();
+    for (const VertexId target : targets) {
+        batch.AddRoute(ReconstructRoute(scratch, from, target, batch.edges));
+    }
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::GetRouteWeights(VertexId from, const std::vector<VertexId>& targets,
+                                             std::vector<std::optional<Weight>>& weights) const {
+    Scratch& scratch = PrepareScratch(graph_.GetVertexCount());
+    detail::SearchTargets(graph_, from, targets, scratch);
+    weights.clear();
+    for (const VertexId target : targets) {
+        weights.push_back(scratch.IsReached(target) ? std::optional<Weight>(scratch.GetWeight(target)) : std::nullopt);
+    }
+}
+
+template <typename Weight>
+std::optional<Weight> DijkstraRouter<Weight>::ReconstructRoute(const Scratch& scratch, VertexId from, VertexId to,
+                                                               std::vector<EdgeId>& edges) const {
+    if (!scratch.IsReached(to)) {
+        return std::nullopt;
+    }
+    const size_t begin = edges.size();
+    for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(scratch.GetPrevId(vertex)).from) {
+        edges.push_back(scratch.GetPrevId(vertex));
+    }
+    std::reverse(edges.begin() + begin, edges.end());
+
+    return scratch.GetWeight(to);
+}
+
+}  // namespace graph
@@ -1,23 +1,33 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <vector>
-#include <set>
 #include <unordered_map>
 
 namespace transport {
 
+    // Номера остановок и автобусов в каталоге — по порядку добавления
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    // Названия и номера лежат в хранилище строк каталога, см. StringArena
     struct Stop {
-        std::string name;
+        std::string_view name;
         geo::Coordinates coordinates;
-        std::set<std::string> buses_by_stop;
+        StopId id;
+        // Автобусы через остановку по возрастанию номеров, без повторов; участок общего
+        // массива каталога, заполняется в Catalogue::Finalize
+        ranges::Range<const BusId*> buses_by_stop{ nullptr, nullptr };
     };
 
     struct Bus {
-        std::string number;
-        std::vector<const Stop*> stops;
+        std::string_view number;
+        BusId id;
+        std::vector<StopId> stops;
         bool is_circle;
     };
 
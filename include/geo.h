@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace geo {
 
 struct Coordinates {
@@ -15,4 +17,8 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Номер точки на кривой Гильберта, вписанной в прямоугольник [min, max] с сеткой 2^16 × 2^16.
+// Близкие номера — близкие точки, поэтому сортировка по номеру сохраняет соседство на плоскости
+uint64_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max);
+
 }  // namespace geo
\ No newline at end of file
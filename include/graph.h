@@ -2,87 +2,181 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace graph {
 
 using VertexId = size_t;
 using EdgeId = size_t;
+using NameId = uint32_t;
 
+// Ребро хранит не саму подпись, а её номер в таблице имён графа
 template <typename Weight>
 struct Edge {
-    std::string name;
+    NameId name_id;
     size_t quality;
     VertexId from;
     VertexId to;
     Weight weight;
 };
 
+// Граф в сжатом построчном виде (CSR): рёбра лежат отдельными массивами, упорядоченными
+// по исходной вершине, а offsets_[v]..offsets_[v + 1] — номера рёбер, выходящих из v.
+// Добавленные рёбра становятся доступны для обхода после Freeze().
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
+
+    // Добавляет count вершин без рёбер с номерами начиная с GetVertexCount()
+    void AddVertices(size_t count);
+    NameId AddName(std::string name);
     EdgeId AddEdge(const Edge<Weight>& edge);
-    void SetEdges(std::vector<Edge<Weight>> edges);
-    void SetIncidence(std::vector<IncidenceList> incidence_lists);
+    // Упорядочивает рёбра по исходной вершине, сохраняя порядок добавления внутри вершины.
+    // Номера рёбер при этом меняются: возвращается новый номер для каждого старого.
+    std::vector<EdgeId> Freeze();
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    size_t GetNameCount() const;
+    const std::string& GetName(NameId name_id) const;
 
 private:
-    std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    template <typename T>
+    static void Permute(std::vector<T>& values, const std::vector<EdgeId>& new_ids);
+
+    size_t vertex_count_ = 0;
+    bool frozen_ = true;
+    std::vector<EdgeId> offsets_ = std::vector<EdgeId>(1, 0);
+    std::vector<uint32_t> from_;
+    std::vector<uint32_t> to_;
+    std::vector<Weight> weights_;
+    std::vector<NameId> name_ids_;
+    std::vector<uint32_t> qualities_;
+    std::vector<std::string> names_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count)
+    , offsets_(vertex_count + 1, 0) {
+    if (vertex_count > UINT32_MAX) {
+        throw std::length_error("Too many vertices");
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::AddVertices(size_t count) {
+    if (vertex_count_ + count > UINT32_MAX) {
+        throw std::length_error("Too many vertices");
+    }
+    vertex_count_ += count;
+    offsets_.resize(vertex_count_ + 1, offsets_.back());
+}
+
+template <typename Weight>
+NameId DirectedWeightedGraph<Weight>::AddName(std::string name) {
+    names_.push_back(std::move(name));
+    return static_cast<NameId>(names_.size() - 1);
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-    edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    from_.push_back(static_cast<uint32_t>(edge.from));
+    to_.push_back(static_cast<uint32_t>(edge.to));
+    weights_.push_back(edge.weight);
+    name_ids_.push_back(edge.name_id);
+    qualities_.push_back(static_cast<uint32_t>(edge.quality));
+    frozen_ = false;
+    return from_.size() - 1;
 }
 
-template<typename Weight>
-void DirectedWeightedGraph<Weight>::SetEdges(std::vector<Edge<Weight>> edges) {
-    edges_ = edges;
+template <typename Weight>
+std::vector<EdgeId> DirectedWeightedGraph<Weight>::Freeze() {
+    const size_t edge_count = from_.size();
+    std::vector<EdgeId> offsets(vertex_count_ + 1, 0);
+    for (const uint32_t from : from_) {
+        ++offsets[from + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count_; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+
+    std::vector<EdgeId> new_ids(edge_count);
+    std::vector<EdgeId> next = offsets;
+    bool is_sorted = true;
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        new_ids[edge_id] = next[from_[edge_id]]++;
+        is_sorted = is_sorted && new_ids[edge_id] == edge_id;
+    }
+    if (!is_sorted) {
+        Permute(from_, new_ids);
+        Permute(to_, new_ids);
+        Permute(weights_, new_ids);
+        Permute(name_ids_, new_ids);
+        Permute(qualities_, new_ids);
+    }
+    offsets_ = std::move(offsets);
+    frozen_ = true;
+    return new_ids;
 }
 
-template<typename Weight>
-void DirectedWeightedGraph<Weight>::SetIncidence(std::vector<IncidenceList> incidence_lists) {
-    incidence_lists_ = incidence_lists;
+template <typename Weight>
+template <typename T>
+void DirectedWeightedGraph<Weight>::Permute(std::vector<T>& values, const std::vector<EdgeId>& new_ids) {
+    std::vector<T> permuted(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        permuted[new_ids[i]] = std::move(values[i]);
+    }
+    values = std::move(permuted);
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return from_.size();
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return {name_ids_.at(edge_id), qualities_[edge_id], from_[edge_id], to_[edge_id], weights_[edge_id]};
 }
 
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (!frozen_) {
+        throw std::logic_error("Graph should be frozen before traversal");
+    }
+    return {ranges::CountingIterator<EdgeId>(offsets_.at(vertex)),
+            ranges::CountingIterator<EdgeId>(offsets_.at(vertex + 1))};
+}
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetNameCount() const {
+    return names_.size();
+}
+
+template <typename Weight>
+const std::string& DirectedWeightedGraph<Weight>::GetName(NameId name_id) const {
+    return names_.at(name_id);
 }
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -21,14 +21,20 @@ public:
 
     void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const;
 
-    void FillCatalogue(transport::Catalogue& catalogue);
+    // threads_count — потоки для расчёта статистики автобусов в Catalogue::Finalize
+    void FillCatalogue(transport::Catalogue& catalogue, size_t threads_count = 1);
+    // Дополняет каталог из base_requests и возвращает добавленные остановки и автобусы.
+    // Существующие остановки и автобусы переопределять нельзя — для этого нужен make_base
+    std::pair<std::vector<const transport::Stop*>, std::vector<const transport::Bus*>> UpdateCatalogue(transport::Catalogue& catalogue, size_t threads_count = 1);
     renderer::MapRenderer FillRenderSettings(const json::Dict& request_map) const;
     transport::RoutingSettings FillRoutingSettings(const json::Node& settings) const;
     
     const json::Node PrintRoute(const json::Dict& request_map, RequestHandler& rh) const;
     const json::Node PrintStop(const json::Dict& request_map, RequestHandler& rh) const;
     const json::Node PrintMap(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintRouting(const json::Dict& request_map, RequestHandler& rh) const;
+    const json::Node PrintRouting(int id, const std::optional<RequestHandler::RouteView>& routing, RequestHandler& rh) const;
+    const json::Node PrintIsochrone(const json::Dict& request_map, RequestHandler& rh) const;
+    const json::Node PrintMatrix(const json::Dict& request_map, RequestHandler& rh) const;
     
 private:
     json::Document input_;
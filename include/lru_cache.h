@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace concurrency {
+
+// Обращения к кэшу с момента создания: найденные ключи и ненайденные
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Ограниченный LRU-кэш, разбитый на сегменты со своими мьютексами: потоки,
+// обращающиеся к разным ключам, как правило не блокируют друг друга.
+// Ёмкость делится между сегментами почти поровну, вытеснение идёт внутри сегмента.
+template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+class ShardedLruCache {
+public:
+    static constexpr size_t MAX_SHARDS_COUNT = 16;
+
+    explicit ShardedLruCache(size_t capacity)
+        : shards_(std::max<size_t>(std::min(capacity, MAX_SHARDS_COUNT), 1)) {
+        // Остаток от деления достаётся первым сегментам по одному, в сумме ровно capacity
+        for (size_t index = 0; index < shards_.size(); ++index) {
+            shards_[index].capacity = capacity / shards_.size() + (index < capacity % shards_.size() ? 1 : 0);
+        }
+    }
+
+    ShardedLruCache(const ShardedLruCache&) = delete;
+    ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+    // Возвращает копию значения и помечает ключ как недавно использованный
+    std::optional<Value> Get(const Key& key) {
+        Shard& shard = GetShard(key);
+        {
+            std::lock_guard lock(shard.mutex);
+            if (const auto it = shard.index.find(key); it != shard.index.end()) {
+                shard.items.splice(shard.items.begin(), shard.items, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second->second;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    void Put(const Key& key, Value value) {
+        Shard& shard = GetShard(key);
+        if (shard.capacity == 0) {
+            return;
+        }
+        std::lock_guard lock(shard.mutex);
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.items.splice(shard.items.begin(), shard.items, it->second);
+            return;
+        }
+        if (shard.items.size() == shard.capacity) {
+            shard.index.erase(shard.items.back().first);
+            shard.items.pop_back();
+        }
+        shard.items.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.items.begin());
+    }
+
+    CacheStats GetStats() const {
+        return { hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed) };
+    }
+
+private:
+    using Items = std::list<std::pair<Key, Value>>;
+
+    struct Shard {
+        std::mutex mutex;
+        size_t capacity = 0;
+        Items items;
+        std::unordered_map<Key, typename Items::iterator, Hasher> index;
+    };
+
+    Shard& GetShard(const Key& key) {
+        // Перемешивание хеша: std::hash для целых — тождественное отображение
+        uint64_t hash = static_cast<uint64_t>(hasher_(key));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return shards_[hash % shards_.size()];
+    }
+
+    Hasher hasher_;
+    std::vector<Shard> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace concurrency
@@ -4,6 +4,7 @@
 #include "geo.h"
 #include "json.h"
 #include "domain.h"
+#include "transport_catalogue.h"
 
 #include <algorithm>
 
@@ -104,12 +105,13 @@ namespace renderer {
             : render_settings_(render_settings)
         {}
 
-        std::vector<svg::Polyline> GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-        std::vector<svg::Text> GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-        std::vector<svg::Circle> GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
-        std::vector<svg::Text> GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
+        std::vector<svg::Polyline> GetRouteLines(const transport::Catalogue& catalogue, const SphereProjector& sp) const;
+        std::vector<svg::Text> GetBusLabel(const transport::Catalogue& catalogue, const SphereProjector& sp) const;
+        std::vector<svg::Circle> GetStopsSymbols(const std::vector<const transport::Stop*>& stops, const SphereProjector& sp) const;
+        std::vector<svg::Text> GetStopsLabels(const std::vector<const transport::Stop*>& stops, const SphereProjector& sp) const;
 
-        svg::Document GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const;
+        // Автобусы рисуются по возрастанию номеров, остановки на маршрутах — по возрастанию названий
+        svg::Document GetSVG(const transport::Catalogue& catalogue) const;
 
         const RenderSettings& GetRenderSettings() const;
     private:
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GRAPH_MIN_PLUS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace graph {
+
+// Свойства типа веса для плотных таблиц маршрутов. Отсутствующий маршрут хранится
+// как бесконечный вес прямо в таблице, без std::optional, чтобы релаксация шла по
+// сплошным массивам. У целых весов (например, время в десятых долях минуты) роль
+// бесконечности играет половина максимума: сумма двух «бесконечностей» не переполняется.
+template <typename Weight, typename = void>
+struct WeightTraits;
+
+template <typename Weight>
+struct WeightTraits<Weight, std::enable_if_t<std::is_floating_point_v<Weight>>> {
+    static constexpr Weight Infinity() {
+        return std::numeric_limits<Weight>::infinity();
+    }
+};
+
+template <typename Weight>
+struct WeightTraits<Weight, std::enable_if_t<std::is_integral_v<Weight> && std::is_signed_v<Weight>>> {
+    static constexpr Weight Infinity() {
+        return std::numeric_limits<Weight>::max() / 2;
+    }
+};
+
+namespace detail {
+
+inline constexpr uint32_t MIN_PLUS_NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+// Скалярная релаксация строки: row[i] = min(row[i], weight_to_via + via[i]).
+// Последнее ребро берётся из via, а если via[i] — сама опорная вершина, то prev_edge_to_via
+template <typename Weight>
+void RelaxRowScalar(Weight* row_weights, uint32_t* row_prev_edges,
+                    const Weight* via_weights, const uint32_t* via_prev_edges,
+                    Weight weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const Weight candidate_weight = weight_to_via + via_weights[i];
+        if (candidate_weight < row_weights[i]) {
+            row_weights[i] = candidate_weight;
+            row_prev_edges[i] = via_prev_edges[i] != MIN_PLUS_NO_EDGE ? via_prev_edges[i] : prev_edge_to_via;
+        }
+    }
+}
+
+#ifdef GRAPH_MIN_PLUS_AVX2
+
+// Векторные ядра собираются с атрибутом target и вызываются, только если процессор
+// поддерживает AVX2, поэтому сама программа собирается без -mavx2. Сложение и сравнение
+// те же, что в скалярном ядре, без FMA, так что результат совпадает побитово.
+
+// Последние рёбра кандидатов: via_prev, а на месте NO_EDGE — ребро до опорной вершины
+__attribute__((target("avx2")))
+inline __m256i SelectPrevEdges8(const uint32_t* via_prev_edges, __m256i prev_edge_to_via) {
+    const __m256i via_prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(via_prev_edges));
+    const __m256i is_no_edge = _mm256_cmpeq_epi32(via_prev, _mm256_set1_epi32(-1));
+    return _mm256_blendv_epi8(via_prev, prev_edge_to_via, is_no_edge);
+}
+
+__attribute__((target("avx2")))
+inline __m128i SelectPrevEdges4(const uint32_t* via_prev_edges, __m128i prev_edge_to_via) {
+    const __m128i via_prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(via_prev_edges));
+    const __m128i is_no_edge = _mm_cmpeq_epi32(via_prev, _mm_set1_epi32(-1));
+    return _mm_blendv_epi8(via_prev, prev_edge_to_via, is_no_edge);
+}
+
+__attribute__((target("avx2")))
+inline void StorePrevEdges8(uint32_t* row_prev_edges, __m256i candidate_prev, __m256i mask) {
+    __m256i* address = reinterpret_cast<__m256i*>(row_prev_edges);
+    _mm256_storeu_si256(address, _mm256_blendv_epi8(_mm256_loadu_si256(address), candidate_prev, mask));
+}
+
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(double* row_weights, uint32_t* row_prev_edges,
+                         const double* via_weights, const uint32_t* via_prev_edges,
+                         double weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+    const __m256d via_weight = _mm256_set1_pd(weight_to_via);
+    const __m128i via_edge = _mm_set1_epi32(static_cast<int>(prev_edge_to_via));
+    // Маска четырёх 64-битных дорожек сжимается в четыре 32-битные для массива рёбер
+    const __m256i pack_mask = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d row = _mm256_loadu_pd(row_weights + i);
+        const __m256d candidate = _mm256_add_pd(via_weight, _mm256_loadu_pd(via_weights + i));
+        const __m256d is_better = _mm256_cmp_pd(candidate, row, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(is_better) == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(row_weights + i, _mm256_blendv_pd(row, candidate, is_better));
+        const __m128i mask = _mm256_castsi256_si128(
+            _mm256_permutevar8x32_epi32(_mm256_castpd_si256(is_better), pack_mask));
+        __m128i* address = reinterpret_cast<__m128i*>(row_prev_edges + i);
+        _mm_storeu_si128(address, _mm_blendv_epi8(_mm_loadu_si128(address),
+                                                  SelectPrevEdges4(via_prev_edges + i, via_edge), mask));
+    }
+    RelaxRowScalar(row_weights + i, row_prev_edges + i, via_weights + i, via_prev_edges + i,
+                   weight_to_via, prev_edge_to_via, count - i);
+}
+
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(float* row_weights, uint32_t* row_prev_edges,
+                         const float* via_weights, const uint32_t* via_prev_edges,
+                         float weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+    const __m256 via_weight = _mm256_set1_ps(weight_to_via);
+    const __m256i via_edge = _mm256_set1_epi32(static_cast<int>(prev_edge_to_via));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 row = _mm256_loadu_ps(row_weights + i);
+        const __m256 candidate = _mm256_add_ps(via_weight, _mm256_loadu_ps(via_weights + i));
+        const __m256 is_better = _mm256_cmp_ps(candidate, row, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(is_better) == 0) {
+            continue;
+        }
+        _mm256_storeu_ps(row_weights + i, _mm256_blendv_ps(row, candidate, is_better));
+        StorePrevEdges8(row_prev_edges + i, SelectPrevEdges8(via_prev_edges + i, via_edge),
+                        _mm256_castps_si256(is_better));
+    }
+    RelaxRowScalar(row_weights + i, row_prev_edges + i, via_weights + i, via_prev_edges + i,
+                   weight_to_via, prev_edge_to_via, count - i);
+}
+
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(int32_t* row_weights, uint32_t* row_prev_edges,
+                         const int32_t* via_weights, const uint32_t* via_prev_edges,
+                         int32_t weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+    const __m256i via_weight = _mm256_set1_epi32(weight_to_via);
+    const __m256i via_edge = _mm256_set1_epi32(static_cast<int>(prev_edge_to_via));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i* row_address = reinterpret_cast<__m256i*>(row_weights + i);
+        const __m256i row = _mm256_loadu_si256(row_address);
+        const __m256i candidate = _mm256_add_epi32(
+            via_weight, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(via_weights + i)));
+        const __m256i is_better = _mm256_cmpgt_epi32(row, candidate);
+        if (_mm256_testz_si256(is_better, is_better)) {
+            continue;
+        }
+        _mm256_storeu_si256(row_address, _mm256_blendv_epi8(row, candidate, is_better));
+        StorePrevEdges8(row_prev_edges + i, SelectPrevEdges8(via_prev_edges + i, via_edge), is_better);
+    }
+    RelaxRowScalar(row_weights + i, row_prev_edges + i, via_weights + i, via_prev_edges + i,
+                   weight_to_via, prev_edge_to_via, count - i);
+}
+
+inline bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif  // GRAPH_MIN_PLUS_AVX2
+
+template <typename Weight>
+inline constexpr bool HAS_VECTOR_MIN_PLUS = std::is_same_v<Weight, double> || std::is_same_v<Weight, float>
+    || std::is_same_v<Weight, int32_t>;
+
+// Релаксация строки с выбором ядра во время выполнения: AVX2 для double, float и int32_t,
+// если процессор его поддерживает, иначе скалярный цикл
+template <typename Weight>
+void RelaxRow(Weight* row_weights, uint32_t* row_prev_edges,
+              const Weight* via_weights, const uint32_t* via_prev_edges,
+              Weight weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+#ifdef GRAPH_MIN_PLUS_AVX2
+    if constexpr (HAS_VECTOR_MIN_PLUS<Weight>) {
+        if (HasAvx2()) {
+            RelaxRowAvx2(row_weights, row_prev_edges, via_weights, via_prev_edges,
+                         weight_to_via, prev_edge_to_via, count);
+            return;
+        }
+    }
+#endif
+    RelaxRowScalar(row_weights, row_prev_edges, via_weights, via_prev_edges,
+                   weight_to_via, prev_edge_to_via, count);
+}
+
+}  // namespace detail
+
+}  // namespace graph
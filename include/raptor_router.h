@@ -0,0 +1,74 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace transport {
+
+// Маршрутизатор RAPTOR: граф не строится, запрос решается по раундам, в раунде k
+// просматриваются линии через остановки, улучшенные в раунде k - 1, и находятся
+// лучшие пути ровно из k поездок. Память линейна по числу вхождений остановок в линии.
+class RaptorRouter {
+public:
+    // Линия — последовательность остановок одного направления автобуса
+    struct Line {
+        graph::NameId name_id;
+        double wait_time;
+        std::vector<uint32_t> stops;
+        // Расстояние от первой остановки линии до каждой из остановок
+        std::vector<int> distances;
+    };
+
+    // Поездка: ожидание на остановке board_stop и проезд span_count перегонов до alight_stop
+    struct Leg {
+        graph::NameId name_id;
+        uint32_t board_stop;
+        uint32_t alight_stop;
+        size_t span_count;
+        double wait_time;
+        double ride_time;
+    };
+
+    // speed — скорость автобуса в метрах в минуту
+    RaptorRouter(size_t stops_count, double speed, const std::vector<Line>& lines);
+
+    std::optional<std::vector<Leg>> BuildRoute(uint32_t from, uint32_t to) const;
+    // Лучшее время до каждой остановки, если оно не больше max_time, иначе бесконечность.
+    // Раунды идут без цели, но остановки за пределом бюджета не отмечаются
+    std::vector<double> GetArrivalTimes(uint32_t from, double max_time) const;
+
+private:
+    // Метка остановки в раунде: на какой линии и между какими позициями к ней приехали
+    struct Label {
+        uint32_t line = NO_LINE;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+    };
+
+    struct LineStop {
+        uint32_t line;
+        uint32_t position;
+    };
+
+    static constexpr uint32_t NO_LINE = UINT32_MAX;
+
+    double GetRideTime(uint32_t line, uint32_t board_position, uint32_t alight_position) const;
+    std::vector<Leg> ReconstructRoute(const std::vector<std::vector<Label>>& labels, uint32_t from, uint32_t to,
+                                      size_t round) const;
+
+    size_t stops_count_;
+    double speed_;
+    std::vector<graph::NameId> line_name_ids_;
+    std::vector<double> line_wait_times_;
+    std::vector<uint32_t> line_offsets_;
+    std::vector<uint32_t> line_stops_;
+    std::vector<int> line_distances_;
+    // Для каждой остановки — линии, проходящие через неё, с позициями на линии
+    std::vector<uint32_t> stop_line_offsets_;
+    std::vector<LineStop> stop_lines_;
+};
+
+}  // namespace transport
@@ -10,7 +10,7 @@
 
 class RequestHandler {
 public:
-    using Route = std::optional<std::vector<graph::Edge<double>>>;
+    using RouteView = transport::TransportRouter::RouteView;
     using Graph = graph::DirectedWeightedGraph<double>;
     RequestHandler(const transport::Catalogue& catalogue, const renderer::MapRenderer& renderer,const transport::TransportRouter& router)
         : catalogue_(catalogue)
@@ -21,10 +21,14 @@ public:
     
     
     std::optional<transport::BusStat> GetBusStat(const std::string_view bus_number) const;
-    const std::set<std::string> GetBusesByStop(std::string_view stop_name) const;
+    // Номера автобусов через остановку по возрастанию; строки принадлежат каталогу
+    std::vector<std::string_view> GetBusesByStop(std::string_view stop_name) const;
     bool IsBusNumber(const std::string_view bus_number) const;
     bool IsStopName(const std::string_view stop_name) const;
-    const Route GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    std::vector<std::optional<RouteView>> GetOptimalRouteViews(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const;
+    std::vector<transport::ReachableStop> GetReachableStops(const std::string_view stop_from, double max_time) const;
+    std::vector<double> GetTravelTimes(const std::vector<std::string_view>& origins, const std::vector<std::string_view>& destinations) const;
+    std::string_view GetRouteItemName(const graph::Edge<double>& edge) const;
     svg::Document RenderMap() const;
 
 private:
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "graph.h"
+#include "min_plus.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <new>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,104 +18,498 @@
 
 namespace graph {
 
+// Аллокатор с выравниванием начала массива по границе Alignment байт
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t{Alignment});
+    }
+
+    friend bool operator==(const AlignedAllocator&, const AlignedAllocator&) {
+        return true;
+    }
+
+    friend bool operator!=(const AlignedAllocator&, const AlignedAllocator&) {
+        return false;
+    }
+};
+
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, CACHE_LINE_SIZE>>;
+
 template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    explicit Router(const Graph& graph, size_t threads_count = 1);
 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
+    // Таблица маршрутов в виде двух плоских массивов. Путь возможен только внутри компоненты
+    // слабой связности, поэтому у каждой компоненты свой квадратный блок, строки подряд, а блоки
+    // идут по возрастанию наименьшей вершины компоненты; вершины внутри блока — по возрастанию
+    // номеров. Отсутствующий маршрут — бесконечный вес, отсутствующее последнее ребро — NO_EDGE
+    struct RoutesTable {
+        AlignedVector<Weight> weights;
+        AlignedVector<uint32_t> prev_edges;
+    };
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    Router(const Graph& graph, RoutesTable routes_table);
+
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Рёбра восстанавливаются из таблицы двумя проходами, сразу в прямом порядке
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Только вес маршрута — одно чтение таблицы без восстановления рёбер
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+    const RoutesTable& GetRoutesTable() const;
+
+    // Дополняет таблицу после того, как в граф добавили вершины и рёбра и снова заморозили его.
+    // new_edge_ids — результат Freeze(), рёбра с прежними номерами от old_edge_count и выше — новые.
+    // Годится и для рёбер, уменьшивших вес; увеличение веса требует полного пересчёта.
+    void AddEdges(const std::vector<EdgeId>& new_edge_ids, size_t old_edge_count);
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    static_assert(NO_EDGE == detail::MIN_PLUS_NO_EDGE, "Routes table and min-plus kernels disagree on NO_EDGE");
+    static constexpr Weight INFINITE_WEIGHT = WeightTraits<Weight>::Infinity();
+
+    // Компонента слабой связности занимает в таблице блок size×size, начиная с offset
+    struct Component {
+        size_t size;
+        size_t offset;
+    };
+
+    // Блок таблицы одной компоненты; номера вершин в нём локальные
+    struct Block {
+        Weight* weights;
+        uint32_t* prev_edges;
+        size_t size;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+    // Разбивает вершины на компоненты слабой связности системой непересекающихся множеств
+    void BuildComponents() {
+        std::vector<VertexId> parents(vertex_count_);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            parents[vertex] = vertex;
+        }
+        const auto find_root = [&parents](VertexId vertex) {
+            while (parents[vertex] != vertex) {
+                parents[vertex] = parents[parents[vertex]];
+                vertex = parents[vertex];
+            }
+            return vertex;
+        };
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto edge = graph_.GetEdge(edge_id);
+            const VertexId from_root = find_root(edge.from);
+            const VertexId to_root = find_root(edge.to);
+            if (from_root != to_root) {
+                parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+            }
+        }
+
+        // Корень — наименьшая вершина компоненты, поэтому он встречается раньше остальных
+        component_ids_.assign(vertex_count_, 0);
+        local_ids_.assign(vertex_count_, 0);
+        components_.clear();
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            const VertexId root = find_root(vertex);
+            if (root == vertex) {
+                component_ids_[vertex] = static_cast<uint32_t>(components_.size());
+                components_.push_back({0, 0});
+            }
+            else {
+                component_ids_[vertex] = component_ids_[root];
+            }
+            local_ids_[vertex] = static_cast<uint32_t>(components_[component_ids_[vertex]].size++);
+        }
+        size_t offset = 0;
+        for (Component& component : components_) {
+            component.offset = offset;
+            offset += component.size * component.size;
+        }
+    }
+
+    size_t GetCellsCount() const {
+        return components_.empty() ? 0 : components_.back().offset + components_.back().size * components_.back().size;
+    }
+
+    // Ячейка маршрута from → to; вершины должны лежать в одной компоненте
+    size_t GetCellIndex(VertexId from, VertexId to) const {
+        const Component& component = components_[component_ids_[from]];
+        return component.offset + static_cast<size_t>(local_ids_[from]) * component.size + local_ids_[to];
+    }
+
+    Block GetBlock(size_t component_id) {
+        const Component& component = components_[component_id];
+        return {routes_table_.weights.data() + component.offset,
+                routes_table_.prev_edges.data() + component.offset,
+                component.size};
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+        routes_table_.weights.assign(GetCellsCount(), INFINITE_WEIGHT);
+        routes_table_.prev_edges.assign(GetCellsCount(), NO_EDGE);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            routes_table_.weights[GetCellIndex(vertex, vertex)] = ZERO_WEIGHT;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t index = GetCellIndex(vertex, edge.to);
+                if (routes_table_.weights[index] > edge.weight) {
+                    routes_table_.weights[index] = edge.weight;
+                    routes_table_.prev_edges[index] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Перестраивает разбиение под выросший граф и переносит в новые блоки известные маршруты.
+    // Компоненты могут только сливаться, поэтому каждая прежняя пара остаётся внутри одного блока
+    void RepartitionRoutesTable() {
+        const std::vector<uint32_t> old_component_ids = std::move(component_ids_);
+        const std::vector<uint32_t> old_local_ids = std::move(local_ids_);
+        const std::vector<Component> old_components = std::move(components_);
+        const RoutesTable old_table = std::move(routes_table_);
+        const size_t old_vertex_count = old_component_ids.size();
+
+        vertex_count_ = graph_.GetVertexCount();
+        BuildComponents();
+        routes_table_.weights.assign(GetCellsCount(), INFINITE_WEIGHT);
+        routes_table_.prev_edges.assign(GetCellsCount(), NO_EDGE);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            routes_table_.weights[GetCellIndex(vertex, vertex)] = ZERO_WEIGHT;
+        }
+
+        std::vector<std::vector<VertexId>> old_members(old_components.size());
+        for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex) {
+            old_members[old_component_ids[vertex]].push_back(vertex);
+        }
+        for (size_t component_id = 0; component_id < old_components.size(); ++component_id) {
+            const Component& component = old_components[component_id];
+            for (const VertexId from : old_members[component_id]) {
+                const size_t old_row = component.offset + static_cast<size_t>(old_local_ids[from]) * component.size;
+                for (const VertexId to : old_members[component_id]) {
+                    const size_t index = GetCellIndex(from, to);
+                    routes_table_.weights[index] = old_table.weights[old_row + old_local_ids[to]];
+                    routes_table_.prev_edges[index] = old_table.prev_edges[old_row + old_local_ids[to]];
+                }
+            }
+        }
+    }
+
+    // Флойд–Уоршелл в каждой компоненте; блочный параллельный вариант — для крупных компонент
+    void RelaxRoutesInternalData(size_t threads_count) {
+        std::optional<concurrency::ThreadPool> pool;
+        for (size_t component_id = 0; component_id < components_.size(); ++component_id) {
+            const Block block = GetBlock(component_id);
+            if (threads_count > 1 && block.size > BLOCK_SIZE) {
+                if (!pool) {
+                    pool.emplace(threads_count);
+                }
+                RelaxRoutesInternalDataBlocked(block, *pool);
+                continue;
+            }
+            for (VertexId vertex_through = 0; vertex_through < block.size; ++vertex_through) {
+                RelaxRoutesInternalDataThroughVertex(block, vertex_through);
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
+    // Релаксация строки маршрутов через промежуточную вершину: row[j] = min(row[j], weight_to_via + via[j]).
+    // Бесконечность в via даёт бесконечного кандидата, поэтому отдельной проверки не нужно.
+    // Ядро выбирается во время выполнения, см. detail::RelaxRow.
+    static void RelaxRow(Weight* row_weights, uint32_t* row_prev_edges,
+                         const Weight* via_weights, const uint32_t* via_prev_edges,
+                         Weight weight_to_via, uint32_t prev_edge_to_via, size_t count) {
+        detail::RelaxRow(row_weights, row_prev_edges, via_weights, via_prev_edges,
+                         weight_to_via, prev_edge_to_via, count);
+    }
+
+    static void RelaxRoutesInternalDataThroughVertex(const Block& block, VertexId vertex_through) {
+        const size_t vertex_count = block.size;
+        Weight* weights = block.weights;
+        uint32_t* prev_edges = block.prev_edges;
+        const size_t through_offset = vertex_through * vertex_count;
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+            const size_t from_offset = vertex_from * vertex_count;
+            const Weight weight_from = weights[from_offset + vertex_through];
+            if (weight_from == INFINITE_WEIGHT || vertex_from == vertex_through) {
+                continue;
+            }
+            RelaxRow(weights + from_offset, prev_edges + from_offset,
+                     weights + through_offset, prev_edges + through_offset,
+                     weight_from, prev_edges[from_offset + vertex_through], vertex_count);
+        }
+    }
+
+    // Строки и столбцы опорных вершин блока: pivot_count полос по vertex_count значений
+    struct PivotStripes {
+        AlignedVector<Weight> row_weights;
+        AlignedVector<uint32_t> row_prev_edges;
+        AlignedVector<Weight> column_weights;
+        AlignedVector<uint32_t> column_prev_edges;
+    };
+
+    // Блочный Флойд–Уоршелл. Для блока опорных вершин сначала фиксируются строки и столбцы
+    // опорных вершин в том виде, в каком их видит последовательный алгоритм на своём шаге:
+    // диагональный блок, затем панели строк и столбцов. После этого все плитки матрицы
+    // релаксируются независимо, в том же порядке опорных вершин — результат побитово
+    // совпадает с RelaxRoutesInternalDataThroughVertex.
+    static void RelaxRoutesInternalDataBlocked(const Block& routes_block, concurrency::ThreadPool& pool) {
+        const size_t vertex_count = routes_block.size;
+        const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        PivotStripes stripes{
+            AlignedVector<Weight>(BLOCK_SIZE * vertex_count),
+            AlignedVector<uint32_t>(BLOCK_SIZE * vertex_count),
+            AlignedVector<Weight>(BLOCK_SIZE * vertex_count),
+            AlignedVector<uint32_t>(BLOCK_SIZE * vertex_count)};
+        Weight* weights = routes_block.weights;
+        uint32_t* prev_edges = routes_block.prev_edges;
+
+        for (size_t pivot_block = 0; pivot_block < block_count; ++pivot_block) {
+            const VertexId pivot_begin = pivot_block * BLOCK_SIZE;
+            const size_t pivot_count = std::min(BLOCK_SIZE, vertex_count - pivot_begin);
+
+            for (size_t pivot = 0; pivot < pivot_count; ++pivot) {
+                const size_t pivot_offset = (pivot_begin + pivot) * vertex_count;
+                std::copy_n(weights + pivot_offset, vertex_count, stripes.row_weights.data() + pivot * vertex_count);
+                std::copy_n(prev_edges + pivot_offset, vertex_count, stripes.row_prev_edges.data() + pivot * vertex_count);
+                for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                    stripes.column_weights[pivot * vertex_count + vertex] = weights[vertex * vertex_count + pivot_begin + pivot];
+                    stripes.column_prev_edges[pivot * vertex_count + vertex] = prev_edges[vertex * vertex_count + pivot_begin + pivot];
+                }
+            }
+            PreparePivotStripes(vertex_count, pivot_begin, pivot_count, pivot_begin, pivot_begin + pivot_count, stripes);
+            pool.ParallelFor(block_count, [&](size_t block) {
+                if (block == pivot_block) {
+                    return;
+                }
+                const VertexId begin = block * BLOCK_SIZE;
+                const VertexId end = std::min(begin + BLOCK_SIZE, vertex_count);
+                PreparePivotStripes(vertex_count, pivot_begin, pivot_count, begin, end, stripes);
+            });
+            pool.ParallelFor(block_count * block_count, [&](size_t tile) {
+                const VertexId from_begin = tile / block_count * BLOCK_SIZE;
+                const VertexId from_end = std::min(from_begin + BLOCK_SIZE, vertex_count);
+                const VertexId to_begin = tile % block_count * BLOCK_SIZE;
+                const size_t to_count = std::min(to_begin + BLOCK_SIZE, vertex_count) - to_begin;
+                for (VertexId vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+                    const size_t row_offset = vertex_from * vertex_count + to_begin;
+                    for (size_t pivot = 0; pivot < pivot_count; ++pivot) {
+                        const Weight weight_from = stripes.column_weights[pivot * vertex_count + vertex_from];
+                        if (weight_from == INFINITE_WEIGHT) {
+                            continue;
+                        }
+                        RelaxRow(weights + row_offset, prev_edges + row_offset,
+                                 stripes.row_weights.data() + pivot * vertex_count + to_begin,
+                                 stripes.row_prev_edges.data() + pivot * vertex_count + to_begin,
+                                 weight_from, stripes.column_prev_edges[pivot * vertex_count + vertex_from], to_count);
+                    }
+                }
+            });
+        }
+    }
+
+    // Доводит строки и столбцы опорных вершин на отрезке [begin, end) до шага своей опорной вершины
+    static void PreparePivotStripes(size_t vertex_count, VertexId pivot_begin, size_t pivot_count,
+                                    VertexId begin, VertexId end, PivotStripes& stripes) {
+        for (size_t pivot = 1; pivot < pivot_count; ++pivot) {
+            const size_t pivot_offset = pivot * vertex_count;
+            for (size_t previous = 0; previous < pivot; ++previous) {
+                const size_t previous_offset = previous * vertex_count;
+                const size_t via_index = previous_offset + pivot_begin + pivot;
+
+                const Weight row_via_weight = stripes.column_weights[via_index];
+                if (row_via_weight != INFINITE_WEIGHT) {
+                    RelaxRow(stripes.row_weights.data() + pivot_offset + begin,
+                             stripes.row_prev_edges.data() + pivot_offset + begin,
+                             stripes.row_weights.data() + previous_offset + begin,
+                             stripes.row_prev_edges.data() + previous_offset + begin,
+                             row_via_weight, stripes.column_prev_edges[via_index], end - begin);
+                }
+
+                const Weight column_via_weight = stripes.row_weights[via_index];
+                const uint32_t column_via_prev_edge = stripes.row_prev_edges[via_index];
+                if (column_via_weight == INFINITE_WEIGHT) {
+                    continue;
+                }
+                for (VertexId vertex = begin; vertex < end; ++vertex) {
+                    const Weight candidate_weight = stripes.column_weights[previous_offset + vertex] + column_via_weight;
+                    if (candidate_weight < stripes.column_weights[pivot_offset + vertex]) {
+                        stripes.column_weights[pivot_offset + vertex] = candidate_weight;
+                        stripes.column_prev_edges[pivot_offset + vertex] = column_via_prev_edge != NO_EDGE
+                            ? column_via_prev_edge
+                            : stripes.column_prev_edges[previous_offset + vertex];
                     }
                 }
             }
         }
     }
 
+    static constexpr size_t BLOCK_SIZE = 64;
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_;
+    // Для каждой вершины — её компонента и номер внутри блока компоненты
+    std::vector<uint32_t> component_ids_;
+    std::vector<uint32_t> local_ids_;
+    std::vector<Component> components_;
+    RoutesTable routes_table_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t threads_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
 {
+    BuildComponents();
     InitializeRoutesInternalData(graph);
+    RelaxRoutesInternalData(threads_count);
+}
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, RoutesTable routes_table)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , routes_table_(std::move(routes_table))
+{
+    BuildComponents();
+    if (routes_table_.weights.size() != GetCellsCount()
+        || routes_table_.prev_edges.size() != routes_table_.weights.size()) {
+        throw std::invalid_argument("Routes table does not match the graph");
     }
 }
 
+template <typename Weight>
+void Router<Weight>::AddEdges(const std::vector<EdgeId>& new_edge_ids, size_t old_edge_count) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    for (uint32_t& prev_edge : routes_table_.prev_edges) {
+        if (prev_edge != NO_EDGE) {
+            prev_edge = static_cast<uint32_t>(new_edge_ids[prev_edge]);
+        }
+    }
+    RepartitionRoutesTable();
+
+    // Улучшенный путь проходит через новые рёбра, а между ними идёт по прежним кратчайшим
+    // путям, уже записанным в таблице. Поэтому достаточно шагов Флойда–Уоршелла только
+    // через концы новых рёбер: O(V²) на вершину вместо O(V³) на всю таблицу.
+    std::vector<VertexId> pivots;
+    pivots.reserve((new_edge_ids.size() - old_edge_count) * 2);
+    for (EdgeId old_id = old_edge_count; old_id < new_edge_ids.size(); ++old_id) {
+        const EdgeId edge_id = new_edge_ids[old_id];
+        const auto edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        const size_t index = GetCellIndex(edge.from, edge.to);
+        if (routes_table_.weights[index] > edge.weight) {
+            routes_table_.weights[index] = edge.weight;
+            routes_table_.prev_edges[index] = static_cast<uint32_t>(edge_id);
+        }
+        pivots.push_back(edge.from);
+        pivots.push_back(edge.to);
+    }
+    std::sort(pivots.begin(), pivots.end());
+    pivots.erase(std::unique(pivots.begin(), pivots.end()), pivots.end());
+    for (const VertexId vertex_through : pivots) {
+        RelaxRoutesInternalDataThroughVertex(GetBlock(component_ids_[vertex_through]), local_ids_[vertex_through]);
+    }
+}
+
+template <typename Weight>
+const typename Router<Weight>::RoutesTable& Router<Weight>::GetRoutesTable() const {
+    return routes_table_;
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::GetRouteWeight(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    // Между компонентами пути нет, таблица для такой пары даже не хранится
+    if (component_ids_[from] != component_ids_[to]) {
+        return std::nullopt;
+    }
+    const Weight weight = routes_table_.weights[GetCellIndex(from, to)];
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    return weight;
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    std::vector<EdgeId> edges;
+    const std::optional<Weight> weight = BuildRoute(from, to, edges);
+    if (!weight) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<Weight> Router<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    edges.clear();
+    if (component_ids_[from] != component_ids_[to]) {
+        return std::nullopt;
+    }
+    const Weight weight = routes_table_.weights[GetCellIndex(from, to)];
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    // Первый проход считает длину пути, второй пишет рёбра с конца — без разворота
+    size_t edge_count = 0;
+    for (uint32_t edge_id = routes_table_.prev_edges[GetCellIndex(from, to)];
+         edge_id != NO_EDGE;
+         edge_id = routes_table_.prev_edges[GetCellIndex(from, graph_.GetEdge(edge_id).from)])
+    {
+        ++edge_count;
+    }
+    edges.resize(edge_count);
+    for (uint32_t edge_id = routes_table_.prev_edges[GetCellIndex(from, to)];
+         edge_id != NO_EDGE;
+         edge_id = routes_table_.prev_edges[GetCellIndex(from, graph_.GetEdge(edge_id).from)])
     {
-        edges.push_back(*edge_id);
+        edges[--edge_count] = edge_id;
     }
-    std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    return weight;
 }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -14,7 +14,10 @@ namespace serialization {
 
 	using Graph = graph::DirectedWeightedGraph<double>;
 	using Route = std::optional<std::vector<graph::Edge<double>>>;
-	using StopById = std::map<std::string, graph::VertexId>;
+	using StopById = transport::TransportRouter::StopById;
+	using Hierarchy = transport::TransportRouter::Hierarchy;
+	using RoutesTable = graph::Router<double>::RoutesTable;
+	using Landmarks = transport::TransportRouter::AltRouter::Landmarks;
 
 	void Serialize(transport::Catalogue& tc, const renderer::MapRenderer& renderer, const transport::TransportRouter& router, std::ostream& out);
 	proto_transport::TransportCatalogue ParseDB(std::istream& input);
@@ -31,6 +34,9 @@ namespace serialization {
 	void SerializeRouterSettings(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc); \
 	void SerializeGraph(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc);
 	void SerializeStopIds(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc);
+	void SerializeHierarchy(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc);
+	void SerializeRoutesTable(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc);
+	void SerializeLandmarks(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc);
 
 	void DeserializeStops(transport::Catalogue& tc, const proto_transport::TransportCatalogue& proto_tc);
 	void DeserializeStopDistances(transport::Catalogue& tc, const proto_transport::TransportCatalogue& proto_tc);
@@ -38,9 +44,12 @@ namespace serialization {
 	renderer::MapRenderer DeserializeRenderSettings(renderer::RenderSettings& render_settings, const proto_transport::TransportCatalogue& proto_tc);
 	svg::Point DeserializePoint(const proto_svg::Point& proto_point);
 	svg::Color DeserializeColor(const proto_svg::Color& proto_color);
-	transport::TransportRouter DeserializeRouter(const proto_transport::TransportCatalogue& proto_tc);
+	transport::TransportRouter DeserializeRouter(const proto_transport::TransportCatalogue& proto_tc, const transport::Catalogue& tc);
 	transport::RoutingSettings DeserializeRoutingSettings(const proto_transport::TransportCatalogue& proto_tc);
 	StopById DeserializeStopById(const proto_transport::TransportCatalogue& proto_tc);
 	Graph DeserializeGraph(const proto_transport::TransportCatalogue& proto_tc);
+	Hierarchy::Index DeserializeHierarchy(const proto_transport::TransportCatalogue& proto_tc);
+	RoutesTable DeserializeRoutesTable(const proto_transport::TransportCatalogue& proto_tc);
+	Landmarks DeserializeLandmarks(const proto_transport::TransportCatalogue& proto_tc);
 
 } // serialization
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+// Хранилище названий каталога: символы копируются подряд в большие блоки, и каждая строка
+// не требует своего выделения памяти. Блоки не перемещаются, поэтому выданные string_view
+// действительны, пока жив объект, в том числе после его перемещения
+class StringArena {
+public:
+    std::string_view Add(std::string_view value) {
+        if (value.size() > block_size_ - block_used_) {
+            block_size_ = std::max(BLOCK_SIZE, value.size());
+            blocks_.push_back(std::make_unique<char[]>(block_size_));
+            block_used_ = 0;
+        }
+        char* data = blocks_.back().get() + block_used_;
+        std::memcpy(data, value.data(), value.size());
+        block_used_ += value.size();
+        return { data, value.size() };
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_size_ = 0;
+    size_t block_used_ = 0;
+};
+
+}  // namespace transport
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace concurrency {
+
+// Пул потоков для параллельных циклов. Вызывающий поток тоже выполняет задачи,
+// поэтому пул на threads_count потоков держит threads_count - 1 рабочих.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads_count);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    size_t GetThreadsCount() const;
+
+    // Вызывает task(index) для каждого index из [0, count) и ждёт завершения всех вызовов.
+    // Первое исключение из задач пробрасывается вызывающему. Вложенные вызовы не поддерживаются.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop();
+    void RunTasks();
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable job_ready_;
+    std::condition_variable job_done_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t task_count_ = 0;
+    std::atomic<size_t> next_index_{0};
+    size_t active_workers_ = 0;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+}  // namespace concurrency
@@ -2,6 +2,7 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "string_arena.h"
 
 #include <iostream>
 #include <deque>
@@ -19,32 +20,77 @@ namespace transport {
 
 class Catalogue {
 public:
-    struct StopDistancesHasher {
-        size_t operator()(const std::pair<const Stop*, const Stop*>& points) const {
-            size_t hash_first = std::hash<const void*>{}(points.first);
-            size_t hash_second = std::hash<const void*>{}(points.second);
-            return hash_first + hash_second * 37;
-        }
+    using BusIdRange = ranges::Range<std::vector<BusId>::const_iterator>;
+    using StopIdRange = ranges::Range<std::vector<StopId>::const_iterator>;
+
+    // Расстояние по дорогам от from до to в метрах, заданное явно
+    struct RoadDistance {
+        StopId from;
+        StopId to;
+        int distance;
     };
-    
+
+
+    // Резервирует место в индексах по названиям ещё под stops_count остановок и buses_count автобусов
+    void Reserve(size_t stops_count, size_t buses_count);
     void AddStop(std::string_view stop_name, const geo::Coordinates coordinates);
+    // Автобус сразу доступен по номеру, а в buses_by_stop его остановок попадёт только после Finalize
     void AddRoute(std::string_view bus_number, const std::vector<const Stop*>& stops, bool is_circle);
+    // Перестраивает индекс расстояний, упорядоченные списки автобусов и остановок,
+    // buses_by_stop всех остановок и таблицу BusStat по номерам автобусов. Вызывается, когда
+    // загружены все маршруты пачки. Готовая таблица из базы принимается как есть, иначе
+    // считаются только автобусы, добавленные после прошлого вызова: на threads_count потоках,
+    // если новых автобусов не меньше PARALLEL_BUS_STATS_MIN_COUNT
+    void Finalize(size_t threads_count = 1, std::vector<BusStat> bus_stats = {});
     const Bus* FindRoute(std::string_view bus_number) const;
     const Stop* FindStop(std::string_view stop_name) const;
+    const Stop* GetStop(StopId stop_id) const;
+    const Bus* GetBus(BusId bus_id) const;
+    // Повторный вызов для той же пары заменяет расстояние; в GetDistance оно попадёт после Finalize
     void SetDistance(const Stop* from, const Stop* to, const int distance);
+    // Расстояние from → to, а если оно не задано — to → from; 0, если не задано ни одно.
+    // Двоичный поиск по соседям from в индексе Finalize
     int GetDistance(const Stop* from, const Stop* to) const;
-    const std::map<std::string_view, const Bus*> GetSortedAllBuses() const;
-    const std::map<std::string_view, const Stop*> GetSortedAllStops() const;
+    // Все автобусы по возрастанию номеров и все остановки по возрастанию названий.
+    // Списки строятся в Finalize и отдаются без копирования
+    BusIdRange GetSortedBusIds() const;
+    StopIdRange GetSortedStopIds() const;
+    // Чтение из таблицы Finalize; автобус, добавленный после него, считается на месте
     std::optional<transport::BusStat> GetBusStat(const std::string_view bus_number) const;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> GetStopDistances() const;
+    // Статистика всех автобусов по их номерам в каталоге
+    const std::vector<BusStat>& GetBusStats() const;
+    // Явно заданные расстояния без повторов, по возрастанию (from, to) на момент Finalize
+    const std::vector<RoadDistance>& GetStopDistances() const;
 private:
-    size_t UniqueStopsCount(std::string_view bus_number) const;
+    // Сосед остановки в индексе расстояний
+    struct Neighbour {
+        StopId stop_id;
+        int distance;
+    };
+
+    // Меньше автобусов считается в вызывающем потоке: пул потоков обошёлся бы дороже расчёта
+    static constexpr size_t PARALLEL_BUS_STATS_MIN_COUNT = 256;
+
+    void BuildDistanceIndex();
+    size_t UniqueStopsCount(const Bus& bus) const;
+    BusStat ComputeBusStat(const Bus& bus) const;
     
+    StringArena names_;
+    // Номер остановки или автобуса — индекс в своём деке; дек не двигает элементы при росте
     std::deque<Bus> all_buses_;
     std::deque<Stop> all_stops_;
+    // Автобусы всех остановок подряд, на его участки указывают Stop::buses_by_stop
+    std::vector<BusId> stop_bus_ids_;
+    std::vector<BusId> sorted_bus_ids_;
+    std::vector<StopId> sorted_stop_ids_;
+    std::vector<BusStat> bus_stats_;
     std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
     std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> stop_distances_;
+    std::vector<RoadDistance> road_distances_;
+    // Соседи остановки i — distance_neighbours_[distance_offsets_[i], distance_offsets_[i + 1])
+    // по возрастанию номеров; обратное направление уже подставлено там, где прямое не задано
+    std::vector<size_t> distance_offsets_;
+    std::vector<Neighbour> distance_neighbours_;
 };
 
 }
\ No newline at end of file
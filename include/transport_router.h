@@ -1,15 +1,64 @@
 #pragma once
 
+#include "alt_router.h"
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
+#include "lru_cache.h"
+#include "ranges.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
 #include <memory>
+#include <mutex>
 
 namespace transport {
 
+    enum class RouterType {
+        ALL_PAIRS,
+        DIJKSTRA,
+        CONTRACTION_HIERARCHY,
+        RAPTOR,
+        ALT
+    };
+
+    // Устройство графа: COMPLETE — ребро между каждой парой остановок автобуса,
+    // COMPACT — цепочка вершин проезда на каждое направление автобуса, рёбер линейно по длине,
+    // SINGLE_VERTEX — как COMPLETE, но одна вершина на остановку, ожидание входит в вес поездки
+    enum class GraphModel {
+        COMPLETE,
+        COMPACT,
+        SINGLE_VERTEX
+    };
+
+    // Нумерация вершин остановок: ALPHABETICAL — по названиям, HILBERT — вдоль кривой Гильберта
+    // по координатам, чтобы соседние остановки получали близкие номера и лежали рядом в памяти
+    enum class VertexOrder {
+        ALPHABETICAL,
+        HILBERT
+    };
+
     struct RoutingSettings {
         int bus_wait_time_ = 0;
         double bus_velocity_ = 0.0;
+        RouterType router_type_ = RouterType::ALL_PAIRS;
+        size_t threads_count_ = 1;
+        // Число готовых маршрутов в кэше FindRoute; 0 — кэш выключен
+        size_t route_cache_capacity_ = 0;
+        // Интервалы движения автобусов в минутах. В RAPTOR интервал автобуса
+        // заменяет для него bus_wait_time, другие маршрутизаторы его не учитывают
+        std::map<std::string, double> bus_headways_;
+        GraphModel graph_model_ = GraphModel::COMPLETE;
+        // Число ориентиров для ALT: больше — точнее оценки, но больше база и предрасчёт
+        size_t landmarks_count_ = 8;
+        VertexOrder vertex_order_ = VertexOrder::ALPHABETICAL;
+    };
+
+    // Остановка изохроны и время в пути до неё в минутах
+    struct ReachableStop {
+        std::string_view stop_name;
+        double time = 0.0;
     };
 
     class GetRouteData;
@@ -19,32 +68,129 @@ namespace transport {
     public:
         using Graph = graph::DirectedWeightedGraph<double>;
         using Route = std::optional<std::vector<graph::Edge<double>>>;
-        using StopById = std::map<std::string, graph::VertexId>;
+        // Прозрачное сравнение: поиск по string_view без временной строки
+        using StopById = std::map<std::string, graph::VertexId, std::less<>>;
+        // Пункты маршрута в буфере потока, см. FindRouteViews
+        using RouteView = ranges::Range<const graph::Edge<double>*>;
+        using Hierarchy = graph::ContractionHierarchy<double>;
+        using AltRouter = graph::AltRouter<double>;
         constexpr static double KMH_TO_MMIN = 100.0 / 6.0;
-        
-        TransportRouter() = default;
+
+        // Предрасчитанные данные маршрутизатора, сохраняемые в базе
+        struct RouterData {
+            graph::Router<double>::RoutesTable routes_table;
+            Hierarchy::Index hierarchy_index;
+            std::vector<double> ride_times;
+            AltRouter::Landmarks landmarks;
+        };
 
         TransportRouter(const RoutingSettings& settings, const Catalogue& catalogue) :
-            settings_(settings), catalogue_(catalogue) {
+            settings_(settings), thread_pool_(settings_.threads_count_), catalogue_(catalogue) {
             BuildGraph();
+            BuildRouter();
+            IndexStopVertices();
+            InitRouteCache();
+        }
+
+        // Восстановление из базы: ни граф, ни таблица маршрутов не пересчитываются
+        TransportRouter(const RoutingSettings& settings, const Catalogue& catalogue, Graph graph, StopById stop_ids, RouterData router_data) :
+            settings_(settings), thread_pool_(settings_.threads_count_), catalogue_(catalogue), graph_(std::move(graph)), stop_ids_(std::move(stop_ids)),
+            ride_times_(std::move(router_data.ride_times)) {
+            BuildRouter(std::move(router_data));
+            IndexStopVertices();
+            InitRouteCache();
         }
 
+        // Маршрутизаторы ссылаются на graph_, поэтому объект не копируется и не перемещается
+        TransportRouter(const TransportRouter&) = delete;
+        TransportRouter& operator=(const TransportRouter&) = delete;
 
         const Route FindRoute(const std::string_view stop_from, const std::string_view stop_to) const;
-        void SetRoutingSettings(const RoutingSettings& settings);
-        void SetGraph(Graph&& graph);
-        void SetStopByIds(StopById stop_ids);
+        // Маршруты для пачки пар остановок в том же порядке. Пары группируются по началу,
+        // и каждая группа решается одним поиском от начальной остановки
+        std::vector<Route> FindRoutes(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const;
+        // Пачка маршрутов без выделения памяти на каждый: пункты всех маршрутов лежат подряд в одном
+        // буфере потока, представления действительны до следующего вызова в этом же потоке.
+        // Названия пунктов — string_view на имена графа, см. GetEdgeName. С включённым кэшем
+        // или RAPTOR пункты копируются из готовых маршрутов
+        std::vector<std::optional<RouteView>> FindRouteViews(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const;
+        // Добавляет в сеть новые остановки и автобусы, уже внесённые в каталог. Таблица всех пар
+        // дополняется только через концы новых рёбер, остальные маршрутизаторы строятся заново
+        void AddStopsAndBuses(const std::vector<const Stop*>& stops, const std::vector<const Bus*>& buses);
+        // Все остановки, до которых из stop_from можно доехать не дольше max_time минут,
+        // по возрастанию времени, при равном времени — по названию. Время считается как
+        // в FindRoute, но поиск один на все остановки и обрывается на границе бюджета
+        std::vector<ReachableStop> FindReachableStops(const std::string_view stop_from, double max_time) const;
+        // Матрица времён в пути origins × destinations построчно, без списков пунктов маршрута;
+        // недостижимая пара — бесконечность. Строки считаются параллельно, по задаче на начало,
+        // а при таблице всех пар ячейки просто читаются из неё
+        std::vector<double> FindTravelTimes(const std::vector<std::string_view>& origins, const std::vector<std::string_view>& destinations) const;
+
+        // Счётчики попаданий и промахов кэша маршрутов; нули, если кэш выключен
+        concurrency::CacheStats GetRouteCacheStats() const;
+        // Название остановки или автобуса, которым подписано ребро маршрута
+        std::string_view GetEdgeName(const graph::Edge<double>& edge) const;
     private:
-        void FillGraphByStop(const std::map<std::string_view, const Stop*>& stops, Graph& stops_graph);
-        void FillGraphByBus(const std::map<std::string_view, const Bus*>& buses, Graph& stops_graph);
+        // Направление автобуса: остановки по порядку и расстояния до них от первой
+        struct BusLine {
+            std::vector<const Stop*> stops;
+            std::vector<int> distances;
+        };
+
+        std::vector<BusLine> GetBusLines(const Bus& bus) const;
+        bool IsCompactGraph() const;
+        bool IsSingleVertexGraph() const;
+        graph::Edge<double> GetWaitEdge(graph::VertexId stop_vertex) const;
+        void AddBusEdge(graph::Edge<double> edge, Graph& stops_graph);
+        std::vector<graph::EdgeId> FreezeGraph(Graph& stops_graph);
+        std::vector<const Stop*> OrderStops(Catalogue::StopIdRange stop_ids) const;
+        void BuildCompactGraph(const std::vector<const Stop*>& stops, Catalogue::BusIdRange bus_ids);
+        void AddStopToGraph(const Stop& stop, graph::VertexId vertex_id, Graph& stops_graph);
+        void FillGraphByStop(const std::vector<const Stop*>& stops, Graph& stops_graph);
+        std::vector<graph::Edge<double>> MakeBusEdges(const Bus& bus, graph::NameId name_id) const;
+        void FillGraphByBus(Catalogue::BusIdRange bus_ids, Graph& stops_graph);
         void BuildGraph();
+        void BuildRouter(RouterData router_data = {});
+        graph::VertexId GetStopVertex(std::string_view stop_name) const;
+        std::optional<graph::Router<double>::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const;
+        // Общий контракт перегрузок маршрутизаторов с буфером: edges очищается и заполняется рёбрами
+        // маршрута, его ёмкость переиспользуется между вызовами, поэтому на запрос память не выделяется
+        std::optional<double> BuildRoute(graph::VertexId from, graph::VertexId to, std::vector<graph::EdgeId>& edges) const;
+        std::vector<std::optional<graph::Router<double>::RouteInfo>> BuildRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const;
+        // Маршруты группы с общим началом в буферы batch, тот же контракт, что у BuildRoute с буфером
+        void BuildRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets, graph::RouteBatch<double>& batch) const;
+        Route ComputeRoute(graph::VertexId from, graph::VertexId to) const;
+        std::vector<Route> ComputeRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const;
+        Route MakeRoute(const std::optional<graph::Router<double>::RouteInfo>& routing) const;
+        void AppendRouteItems(ranges::Range<const graph::EdgeId*> edges, std::vector<graph::Edge<double>>& route) const;
+        Route MakeRoute(const std::optional<std::vector<RaptorRouter::Leg>>& legs) const;
+        std::unique_ptr<RaptorRouter> MakeRaptorRouter() const;
+        void IndexStopVertices();
+        void InitRouteCache();
+        static uint64_t GetRouteCacheKey(graph::VertexId from, graph::VertexId to) {
+            return (static_cast<uint64_t>(from) << 32) | static_cast<uint64_t>(to);
+        }
 
         RoutingSettings settings_;
+        // Один пул на всё время жизни маршрутизатора: запросы не создают потоков. ParallelFor
+        // не допускает одновременных вызовов, поэтому const-запросы берут пул под мьютексом
+        mutable concurrency::ThreadPool thread_pool_;
+        mutable std::mutex thread_pool_mutex_;
 
-        const Catalogue& catalogue_{};
+        const Catalogue& catalogue_;
         Graph graph_;
         StopById stop_ids_;
+        // Название остановки по её вершине, у прочих вершин пусто
+        std::vector<std::string_view> stop_names_;
+        // Только для SINGLE_VERTEX: время проезда без ожидания по номеру ребра графа
+        std::vector<double> ride_times_;
         std::unique_ptr<graph::Router<double>> router_; 
+        std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_;
+        std::unique_ptr<Hierarchy> hierarchy_;
+        std::unique_ptr<AltRouter> alt_router_;
+        std::unique_ptr<RaptorRouter> raptor_router_;
+        // Ключ — пара вершин (откуда, куда), упакованная в одно число, см. GetRouteCacheKey
+        std::unique_ptr<concurrency::ShardedLruCache<uint64_t, Route>> route_cache_;
     };
 
     class GetRouteData  {
@@ -52,5 +198,9 @@ namespace transport {
         const RoutingSettings& GetRoutingSettings(const transport::TransportRouter& router) const;
         const TransportRouter::StopById& GetStopIds(const transport::TransportRouter& router) const;
         const TransportRouter::Graph& GetGraph(const transport::TransportRouter& router) const;
+        const graph::Router<double>* GetRouter(const transport::TransportRouter& router) const;
+        const std::vector<double>& GetRideTimes(const transport::TransportRouter& router) const;
+        const TransportRouter::Hierarchy* GetHierarchy(const transport::TransportRouter& router) const;
+        const TransportRouter::AltRouter* GetAltRouter(const transport::TransportRouter& router) const;
     };
 }
\ No newline at end of file
@@ -8,7 +8,7 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
@@ -22,9 +22,9 @@ int main(int argc, char* argv[]) {
     if (mode == "make_base"sv) {
         JsonReader json_input(std::cin);
         transport::Catalogue catalogue;
-        json_input.FillCatalogue(catalogue);
-
         const auto& routing_settings = json_input.FillRoutingSettings(json_input.GetRoutingSettings());
+        json_input.FillCatalogue(catalogue, routing_settings.threads_count_);
+
         const transport::TransportRouter router = { routing_settings, catalogue };
         const auto& render_settings = json_input.GetRenderSettings().AsDict();
         const auto& renderer = json_input.FillRenderSettings(render_settings);
@@ -35,18 +35,41 @@ int main(int argc, char* argv[]) {
             serialization::Serialize(catalogue, renderer, router, fout);
         }
         fout.close();
+    } else if (mode == "update_base"sv) {
+        // Новые остановки и автобусы добавляются в готовую базу без полного пересчёта маршрутов
+        JsonReader json_input(std::cin);
+        const std::string& file = json_input.GetSerializationSettings().AsDict().at("file"s).AsString();
+        std::ifstream db_file(file, std::ios::binary);
+        if (db_file) {
+            auto proto_tc = serialization::ParseDB(db_file);
+            db_file.close();
+            auto [catalogue, renderer] = serialization::Deserialize(proto_tc);
+            transport::TransportRouter router = serialization::DeserializeRouter(proto_tc, catalogue);
+            const auto [stops, buses] = json_input.UpdateCatalogue(catalogue, serialization::DeserializeRoutingSettings(proto_tc).threads_count_);
+            router.AddStopsAndBuses(stops, buses);
+
+            std::ofstream fout(file, std::ios::binary);
+            if (fout.is_open()) {
+                serialization::Serialize(catalogue, renderer, router, fout);
+            }
+        }
     } else if (mode == "process_requests"sv) {
         JsonReader json_input(std::cin);
         std::ifstream db_file(json_input.GetSerializationSettings().AsDict().at("file"s).AsString(), std::ios::binary);
         if (db_file) {
             auto proto_tc = serialization::ParseDB(db_file);
             auto [catalogue, renderer] = serialization::Deserialize(proto_tc);
-            auto routing_settings = serialization::DeserializeRoutingSettings(proto_tc);
-            transport::TransportRouter router{ routing_settings, catalogue };
+            const transport::TransportRouter router = serialization::DeserializeRouter(proto_tc, catalogue);
             const auto& stat_requests = json_input.GetStatRequests();
             RequestHandler rh{ catalogue, renderer, router };
 
             json_input.ProcessRequests(stat_requests, rh);
+
+            // Доля попаданий показывает, окупается ли route_cache_capacity на этом потоке запросов
+            const concurrency::CacheStats cache_stats = router.GetRouteCacheStats();
+            if (cache_stats.hits + cache_stats.misses > 0) {
+                std::cerr << "route cache: "sv << cache_stats.hits << " hits, "sv << cache_stats.misses << " misses\n"sv;
+            }
         }
     } else {
         PrintUsage();
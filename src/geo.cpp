@@ -1,7 +1,9 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace geo {
 
@@ -16,4 +18,33 @@ double ComputeDistance(Coordinates from, Coordinates to) {
         * 6371000;
 }
 
+uint64_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max) {
+    constexpr uint32_t GRID_SIZE = 1u << 16;
+    const auto to_cell = [](double value, double low, double high) {
+        if (high <= low) {
+            return 0u;
+        }
+        const double cell = (value - low) / (high - low) * (GRID_SIZE - 1);
+        return static_cast<uint32_t>(std::lround(std::clamp(cell, 0.0, GRID_SIZE - 1.0)));
+    };
+    uint32_t x = to_cell(point.lng, min.lng, max.lng);
+    uint32_t y = to_cell(point.lat, min.lat, max.lat);
+
+    uint64_t index = 0;
+    for (uint32_t half = GRID_SIZE / 2; half > 0; half /= 2) {
+        const uint32_t rx = (x & half) ? 1 : 0;
+        const uint32_t ry = (y & half) ? 1 : 0;
+        index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+        // Поворот четверти, чтобы кривая внутри неё шла от входа к выходу
+        if (ry == 0) {
+            if (rx == 1) {
+                x = half - 1 - (x & (half - 1));
+                y = half - 1 - (y & (half - 1));
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
 }  // namespace geo
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "json_reader.h"
 #include "json_builder.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
 const json::Node& JsonReader::GetBaseRequests() const {
     auto it = input_.GetRoot().AsDict().find("base_requests");
     if (it == input_.GetRoot().AsDict().end()) {
@@ -42,6 +46,18 @@ const json::Node& JsonReader::GetSerializationSettings() const {
 }
 
 void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const {
+    // Запросы маршрутов решаются одной пачкой, чтобы маршрутизатор мог
+    // объединить запросы с общей начальной остановкой
+    std::vector<std::pair<std::string_view, std::string_view>> stop_pairs;
+    for (auto& request : stat_requests.AsArray()) {
+        const auto& request_map = request.AsDict();
+        if (request_map.at("type").AsString() == "Route") {
+            stop_pairs.emplace_back(request_map.at("from").AsString(), request_map.at("to").AsString());
+        }
+    }
+    const std::vector<std::optional<RequestHandler::RouteView>> routes = rh.GetOptimalRouteViews(stop_pairs);
+    size_t route_index = 0;
+
     json::Array result;
     for (auto& request : stat_requests.AsArray()) {
         const auto& request_map = request.AsDict();
@@ -56,15 +72,25 @@ void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler
             result.push_back(PrintMap(request_map, rh).AsDict());
         }
         if (type == "Route") {
-            result.push_back(PrintRouting(request_map, rh).AsDict());
+            result.push_back(PrintRouting(request_map.at("id").AsInt(), routes[route_index++], rh).AsDict());
+        }
+        if (type == "Isochrone") {
+            result.push_back(PrintIsochrone(request_map, rh).AsDict());
+        }
+        if (type == "Matrix") {
+            result.push_back(PrintMatrix(request_map, rh).AsDict());
         }
     }
 
     json::Print(json::Document{ result }, std::cout);
 }
 
-void JsonReader::FillCatalogue(transport::Catalogue& catalogue) {
+void JsonReader::FillCatalogue(transport::Catalogue& catalogue, size_t threads_count) {
     const json::Array& arr = GetBaseRequests().AsArray();
+    const size_t stops_count = std::count_if(arr.begin(), arr.end(), [](const json::Node& request) {
+        return request.AsDict().at("type").AsString() == "Stop";
+    });
+    catalogue.Reserve(stops_count, arr.size() - stops_count);
     for (auto& request_stops : arr) {
         const auto& request_stops_map = request_stops.AsDict();
         const auto& type = request_stops_map.at("type").AsString();
@@ -83,6 +109,7 @@ void JsonReader::FillCatalogue(transport::Catalogue& catalogue) {
             catalogue.AddRoute(bus_number, stops, circular_route);
         }
     }
+    catalogue.Finalize(threads_count);
 }
 
 std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> JsonReader::ParseStop(const json::Dict& request_map) const {
@@ -96,6 +123,36 @@ std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>>
     return std::make_tuple(stop_name, coordinates, stop_distances);
 }
 
+std::pair<std::vector<const transport::Stop*>, std::vector<const transport::Bus*>> JsonReader::UpdateCatalogue(transport::Catalogue& catalogue, size_t threads_count) {
+    const json::Array& arr = GetBaseRequests().AsArray();
+    for (auto& request : arr) {
+        const auto& request_map = request.AsDict();
+        const auto& type = request_map.at("type").AsString();
+        const auto& name = request_map.at("name").AsString();
+        if (type == "Stop" && catalogue.FindStop(name)) {
+            throw std::logic_error("stop already exists: " + name);
+        }
+        if (type == "Bus" && catalogue.FindRoute(name)) {
+            throw std::logic_error("bus already exists: " + name);
+        }
+    }
+    FillCatalogue(catalogue, threads_count);
+
+    std::vector<const transport::Stop*> stops;
+    std::vector<const transport::Bus*> buses;
+    for (auto& request : arr) {
+        const auto& request_map = request.AsDict();
+        const auto& type = request_map.at("type").AsString();
+        if (type == "Stop") {
+            stops.push_back(catalogue.FindStop(request_map.at("name").AsString()));
+        }
+        if (type == "Bus") {
+            buses.push_back(catalogue.FindRoute(request_map.at("name").AsString()));
+        }
+    }
+    return { std::move(stops), std::move(buses) };
+}
+
 void JsonReader::FillStopDistances(transport::Catalogue& catalogue) const {
     const json::Array& arr = GetBaseRequests().AsArray();
     for (auto& request_stops: arr) {
@@ -172,7 +229,76 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Dict& request_m
 }
 
 transport::RoutingSettings JsonReader::FillRoutingSettings(const json::Node& settings) const {
-    return transport::RoutingSettings{ settings.AsDict().at("bus_wait_time").AsInt(), settings.AsDict().at("bus_velocity").AsDouble() };
+    const json::Dict& settings_map = settings.AsDict();
+    transport::RoutingSettings routing_settings;
+    routing_settings.bus_wait_time_ = settings_map.at("bus_wait_time").AsInt();
+    routing_settings.bus_velocity_ = settings_map.at("bus_velocity").AsDouble();
+    if (const auto it = settings_map.find("router_type"); it != settings_map.end()) {
+        const std::string& router_type = it->second.AsString();
+        if (router_type == "all_pairs") {
+            routing_settings.router_type_ = transport::RouterType::ALL_PAIRS;
+        }
+        else if (router_type == "dijkstra") {
+            routing_settings.router_type_ = transport::RouterType::DIJKSTRA;
+        }
+        else if (router_type == "contraction_hierarchy") {
+            routing_settings.router_type_ = transport::RouterType::CONTRACTION_HIERARCHY;
+        }
+        else if (router_type == "raptor") {
+            routing_settings.router_type_ = transport::RouterType::RAPTOR;
+        }
+        else if (router_type == "alt") {
+            routing_settings.router_type_ = transport::RouterType::ALT;
+        } else throw std::logic_error("wrong router_type");
+    }
+    if (const auto it = settings_map.find("threads_count"); it != settings_map.end()) {
+        if (it->second.AsInt() < 1) {
+            throw std::logic_error("wrong threads_count");
+        }
+        routing_settings.threads_count_ = static_cast<size_t>(it->second.AsInt());
+    }
+    if (const auto it = settings_map.find("route_cache_capacity"); it != settings_map.end()) {
+        if (it->second.AsInt() < 0) {
+            throw std::logic_error("wrong route_cache_capacity");
+        }
+        routing_settings.route_cache_capacity_ = static_cast<size_t>(it->second.AsInt());
+    }
+    if (const auto it = settings_map.find("landmarks_count"); it != settings_map.end()) {
+        if (it->second.AsInt() < 1) {
+            throw std::logic_error("wrong landmarks_count");
+        }
+        routing_settings.landmarks_count_ = static_cast<size_t>(it->second.AsInt());
+    }
+    if (const auto it = settings_map.find("graph_model"); it != settings_map.end()) {
+        const std::string& graph_model = it->second.AsString();
+        if (graph_model == "complete") {
+            routing_settings.graph_model_ = transport::GraphModel::COMPLETE;
+        }
+        else if (graph_model == "compact") {
+            routing_settings.graph_model_ = transport::GraphModel::COMPACT;
+        }
+        else if (graph_model == "single_vertex") {
+            routing_settings.graph_model_ = transport::GraphModel::SINGLE_VERTEX;
+        } else throw std::logic_error("wrong graph_model");
+    }
+    if (const auto it = settings_map.find("vertex_order"); it != settings_map.end()) {
+        const std::string& vertex_order = it->second.AsString();
+        if (vertex_order == "alphabetical") {
+            routing_settings.vertex_order_ = transport::VertexOrder::ALPHABETICAL;
+        }
+        else if (vertex_order == "hilbert") {
+            routing_settings.vertex_order_ = transport::VertexOrder::HILBERT;
+        } else throw std::logic_error("wrong vertex_order");
+    }
+    if (const auto it = settings_map.find("bus_headways"); it != settings_map.end()) {
+        for (const auto& [bus_number, headway] : it->second.AsDict()) {
+            if (headway.AsDouble() < 0.0) {
+                throw std::logic_error("wrong bus_headways");
+            }
+            routing_settings.bus_headways_[bus_number] = headway.AsDouble();
+        }
+    }
+    return routing_settings;
 }
 
 const json::Node JsonReader::PrintRoute(const json::Dict& request_map, RequestHandler& rh) const {
@@ -217,8 +343,8 @@ const json::Node JsonReader::PrintStop(const json::Dict& request_map, RequestHan
     }
     else {
         json::Array buses;
-        for (auto& bus : rh.GetBusesByStop(stop_name)) {
-            buses.push_back(bus);
+        for (const std::string_view bus : rh.GetBusesByStop(stop_name)) {
+            buses.push_back(std::string(bus));
         }
         result = json::Builder{}
                     .StartDict()
@@ -247,14 +373,9 @@ const json::Node JsonReader::PrintMap(const json::Dict& request_map, RequestHand
     return result;
 }
 
-const json::Node JsonReader::PrintRouting(const json::Dict& request_map, RequestHandler& rh) const {
+const json::Node JsonReader::PrintRouting(int id, const std::optional<RequestHandler::RouteView>& routing, RequestHandler& rh) const {
     using namespace std::string_literals;
     json::Node result;
-    const int id = request_map.at("id").AsInt();
-    const std::string_view stop_from = request_map.at("from").AsString();
-    const std::string_view stop_to = request_map.at("to").AsString();
-    const auto& routing = rh.GetOptimalRoute(stop_from, stop_to);
-    
     if (!routing) {
         result = json::Builder{}
                         .StartDict()
@@ -266,12 +387,12 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
     else {
         json::Array items;
         double total_time = 0.0;
-        items.reserve(routing.value().size());
+        items.reserve(std::distance(routing->begin(), routing->end()));
         for (const auto& edge : routing.value()) {
             if (edge.quality == 0) {
                 items.emplace_back(json::Node(json::Builder{}
                                                         .StartDict()
-                                                            .Key("stop_name").Value(edge.name)
+                                                            .Key("stop_name").Value(std::string(rh.GetRouteItemName(edge)))
                                                             .Key("time").Value(edge.weight)
                                                             .Key("type").Value("Wait"s)
                                                         .EndDict()
@@ -281,7 +402,7 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
             else {
                 items.emplace_back(json::Node(json::Builder{}
                                                     .StartDict()
-                                                        .Key("bus").Value(edge.name)
+                                                        .Key("bus").Value(std::string(rh.GetRouteItemName(edge)))
                                                         .Key("span_count").Value(static_cast<int>(edge.quality))
                                                         .Key("time").Value(edge.weight)
                                                         .Key("type").Value("Bus"s)
@@ -299,4 +420,74 @@ const json::Node JsonReader::PrintRouting(const json::Dict& request_map, Request
                 .Build();
     }
     return result;
+}
+
+const json::Node JsonReader::PrintIsochrone(const json::Dict& request_map, RequestHandler& rh) const {
+    const int id = request_map.at("id").AsInt();
+    const std::string_view stop_from = request_map.at("from").AsString();
+    if (!rh.IsStopName(stop_from)) {
+        return json::Builder{}
+                    .StartDict()
+                        .Key("request_id").Value(id)
+                        .Key("error_message").Value("not found")
+                    .EndDict()
+                .Build();
+    }
+    json::Array stops;
+    for (const auto& [stop_name, time] : rh.GetReachableStops(stop_from, request_map.at("max_time").AsDouble())) {
+        stops.emplace_back(json::Node(json::Builder{}
+                                            .StartDict()
+                                                .Key("stop_name").Value(std::string(stop_name))
+                                                .Key("time").Value(time)
+                                            .EndDict()
+                                        .Build()));
+    }
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id").Value(id)
+                    .Key("stops").Value(stops)
+                .EndDict()
+            .Build();
+}
+
+const json::Node JsonReader::PrintMatrix(const json::Dict& request_map, RequestHandler& rh) const {
+    const int id = request_map.at("id").AsInt();
+    std::vector<std::string_view> origins;
+    std::vector<std::string_view> destinations;
+    for (const auto& stop : request_map.at("origins").AsArray()) {
+        origins.push_back(stop.AsString());
+    }
+    for (const auto& stop : request_map.at("destinations").AsArray()) {
+        destinations.push_back(stop.AsString());
+    }
+    const auto is_unknown = [&rh](std::string_view stop) { return !rh.IsStopName(stop); };
+    if (std::any_of(origins.begin(), origins.end(), is_unknown)
+        || std::any_of(destinations.begin(), destinations.end(), is_unknown)) {
+        return json::Builder{}
+                    .StartDict()
+                        .Key("request_id").Value(id)
+                        .Key("error_message").Value("not found")
+                    .EndDict()
+                .Build();
+    }
+
+    // Недостижимая пара — null
+    const std::vector<double> times = rh.GetTravelTimes(origins, destinations);
+    json::Array rows;
+    rows.reserve(origins.size());
+    for (size_t row = 0; row < origins.size(); ++row) {
+        json::Array row_times;
+        row_times.reserve(destinations.size());
+        for (size_t column = 0; column < destinations.size(); ++column) {
+            const double time = times[row * destinations.size() + column];
+            row_times.emplace_back(std::isinf(time) ? json::Node(nullptr) : json::Node(time));
+        }
+        rows.emplace_back(std::move(row_times));
+    }
+    return json::Builder{}
+                .StartDict()
+                    .Key("request_id").Value(id)
+                    .Key("times").Value(rows)
+                .EndDict()
+            .Build();
 }
\ No newline at end of file
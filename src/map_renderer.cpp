@@ -6,20 +6,21 @@ bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
+std::vector<svg::Polyline> MapRenderer::GetRouteLines(const transport::Catalogue& catalogue, const SphereProjector& sp) const {
     std::vector<svg::Polyline> result;
     size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
+    for (const transport::BusId bus_id : catalogue.GetSortedBusIds()) {
+        const transport::Bus* bus = catalogue.GetBus(bus_id);
         if (bus->stops.empty()) {
             continue;
         }
-        std::vector<const transport::Stop*> route_stops{ bus->stops.begin(), bus->stops.end() };
+        std::vector<transport::StopId> route_stops{ bus->stops.begin(), bus->stops.end() };
         if (bus->is_circle == false) {
             route_stops.insert(route_stops.end(), std::next(bus->stops.rbegin()), bus->stops.rend());
         }
         svg::Polyline line;
-        for (const auto& stop : route_stops) {
-            line.AddPoint(sp(stop->coordinates));
+        for (const transport::StopId stop_id : route_stops) {
+            line.AddPoint(sp(catalogue.GetStop(stop_id)->coordinates));
         }
         line.SetStrokeColor(render_settings_.color_palette[color_num]);
         line.SetFillColor("none");
@@ -38,33 +39,34 @@ std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string
     return result;
 }
 
-std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
+std::vector<svg::Text> MapRenderer::GetBusLabel(const transport::Catalogue& catalogue, const SphereProjector& sp) const {
     std::vector<svg::Text> result;
     size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
+    for (const transport::BusId bus_id : catalogue.GetSortedBusIds()) {
+        const transport::Bus* bus = catalogue.GetBus(bus_id);
         if (bus->stops.empty()) {
             continue;
         }
         svg::Text text;
         svg::Text underlayer;
-        text.SetPosition(sp(bus->stops[0]->coordinates));
+        text.SetPosition(sp(catalogue.GetStop(bus->stops[0])->coordinates));
         text.SetOffset(render_settings_.bus_label_offset);
         text.SetFontSize(render_settings_.bus_label_font_size);
         text.SetFontFamily("Verdana");
         text.SetFontWeight("bold");
-        text.SetData(bus->number);
+        text.SetData(std::string(bus->number));
         text.SetFillColor(render_settings_.color_palette[color_num]);
         if (color_num < (render_settings_.color_palette.size() - 1)) {
             ++color_num;
         }
         else color_num = 0;
         
-        underlayer.SetPosition(sp(bus->stops[0]->coordinates));
+        underlayer.SetPosition(sp(catalogue.GetStop(bus->stops[0])->coordinates));
         underlayer.SetOffset(render_settings_.bus_label_offset);
         underlayer.SetFontSize(render_settings_.bus_label_font_size);
         underlayer.SetFontFamily("Verdana");
         underlayer.SetFontWeight("bold");
-        underlayer.SetData(bus->number);
+        underlayer.SetData(std::string(bus->number));
         underlayer.SetFillColor(render_settings_.underlayer_color);
         underlayer.SetStrokeColor(render_settings_.underlayer_color);
         underlayer.SetStrokeWidth(render_settings_.underlayer_width);
@@ -77,8 +79,8 @@ std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view,
         if (bus->is_circle == false && bus->stops[0] != bus->stops[bus->stops.size() - 1]) {
             svg::Text text2 {text};
             svg::Text underlayer2 {underlayer};
-            text2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
-            underlayer2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
+            text2.SetPosition(sp(catalogue.GetStop(bus->stops.back())->coordinates));
+            underlayer2.SetPosition(sp(catalogue.GetStop(bus->stops.back())->coordinates));
             
             result.push_back(underlayer2);
             result.push_back(text2);
@@ -88,9 +90,9 @@ std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view,
     return result;
 }
 
-std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
+std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::vector<const transport::Stop*>& stops, const SphereProjector& sp) const {
     std::vector<svg::Circle> result;
-    for (const auto& [stop_name, stop] : stops) {
+    for (const transport::Stop* stop : stops) {
         svg::Circle symbol;
         symbol.SetCenter(sp(stop->coordinates));
         symbol.SetRadius(render_settings_.stop_radius);
@@ -102,23 +104,23 @@ std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string
     return result;
 }
 
-std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
+std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::vector<const transport::Stop*>& stops, const SphereProjector& sp) const {
     std::vector<svg::Text> result;
     svg::Text text;
     svg::Text underlayer;
-    for (const auto& [stop_name, stop] : stops) {
+    for (const transport::Stop* stop : stops) {
         text.SetPosition(sp(stop->coordinates));
         text.SetOffset(render_settings_.stop_label_offset);
         text.SetFontSize(render_settings_.stop_label_font_size);
         text.SetFontFamily("Verdana");
-        text.SetData(stop->name);
+        text.SetData(std::string(stop->name));
         text.SetFillColor("black");
         
         underlayer.SetPosition(sp(stop->coordinates));
         underlayer.SetOffset(render_settings_.stop_label_offset);
         underlayer.SetFontSize(render_settings_.stop_label_font_size);
         underlayer.SetFontFamily("Verdana");
-        underlayer.SetData(stop->name);
+        underlayer.SetData(std::string(stop->name));
         underlayer.SetFillColor(render_settings_.underlayer_color);
         underlayer.SetStrokeColor(render_settings_.underlayer_color);
         underlayer.SetStrokeWidth(render_settings_.underlayer_width);
@@ -132,26 +134,30 @@ std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_vi
     return result;
 }
 
-svg::Document MapRenderer::GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const {
+svg::Document MapRenderer::GetSVG(const transport::Catalogue& catalogue) const {
     svg::Document result;
     std::vector<geo::Coordinates> route_stops_coord;
-    std::map<std::string_view, const transport::Stop*> all_stops;
+    const transport::Catalogue::StopIdRange sorted_stop_ids = catalogue.GetSortedStopIds();
+    std::vector<bool> is_route_stop(std::distance(sorted_stop_ids.begin(), sorted_stop_ids.end()), false);
     
-    for (const auto& [bus_number, bus] : buses) {
-        if (bus->stops.empty()) {
-            continue;
+    for (const transport::BusId bus_id : catalogue.GetSortedBusIds()) {
+        for (const transport::StopId stop_id : catalogue.GetBus(bus_id)->stops) {
+            route_stops_coord.push_back(catalogue.GetStop(stop_id)->coordinates);
+            is_route_stop[stop_id] = true;
         }
-        for (const auto& stop : bus->stops) {
-            route_stops_coord.push_back(stop->coordinates);
-            all_stops[stop->name] = stop;
+    }
+    std::vector<const transport::Stop*> all_stops;
+    for (const transport::StopId stop_id : sorted_stop_ids) {
+        if (is_route_stop[stop_id]) {
+            all_stops.push_back(catalogue.GetStop(stop_id));
         }
     }
     SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
     
-    for (const auto& line : GetRouteLines(buses, sp)) {
+    for (const auto& line : GetRouteLines(catalogue, sp)) {
         result.Add(line);
     }
-    for (const auto& text : GetBusLabel(buses, sp)) {
+    for (const auto& text : GetBusLabel(catalogue, sp)) {
         result.Add(text);
     }
     for (const auto& circle : GetStopsSymbols(all_stops, sp)) {
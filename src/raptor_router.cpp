@@ -0,0 +1,216 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace transport {
+
+RaptorRouter::RaptorRouter(size_t stops_count, double speed, const std::vector<Line>& lines)
+    : stops_count_(stops_count)
+    , speed_(speed)
+    , stop_line_offsets_(stops_count + 1, 0) {
+    line_offsets_.reserve(lines.size() + 1);
+    line_offsets_.push_back(0);
+    for (const Line& line : lines) {
+        if (line.stops.size() != line.distances.size()) {
+            throw std::invalid_argument("Line stops and distances differ in size");
+        }
+        line_name_ids_.push_back(line.name_id);
+        line_wait_times_.push_back(line.wait_time);
+        for (size_t position = 0; position < line.stops.size(); ++position) {
+            if (line.stops[position] >= stops_count) {
+                throw std::out_of_range("Stop id is out of range");
+            }
+            line_stops_.push_back(line.stops[position]);
+            line_distances_.push_back(line.distances[position]);
+            ++stop_line_offsets_[line.stops[position] + 1];
+        }
+        line_offsets_.push_back(static_cast<uint32_t>(line_stops_.size()));
+    }
+
+    for (size_t stop = 0; stop < stops_count; ++stop) {
+        stop_line_offsets_[stop + 1] += stop_line_offsets_[stop];
+    }
+    stop_lines_.resize(line_stops_.size());
+    std::vector<uint32_t> next(stop_line_offsets_.begin(), stop_line_offsets_.end() - 1);
+    for (uint32_t line = 0; line < line_name_ids_.size(); ++line) {
+        for (uint32_t index = line_offsets_[line]; index < line_offsets_[line + 1]; ++index) {
+            stop_lines_[next[line_stops_[index]]++] = {line, index - line_offsets_[line]};
+        }
+    }
+}
+
+double RaptorRouter::GetRideTime(uint32_t line, uint32_t board_position, uint32_t alight_position) const {
+    const uint32_t offset = line_offsets_[line];
+    const int distance = line_distances_[offset + alight_position] - line_distances_[offset + board_position];
+    return static_cast<double>(distance) / speed_;
+}
+
+std::optional<std::vector<RaptorRouter::Leg>> RaptorRouter::BuildRoute(uint32_t from, uint32_t to) const {
+    if (from >= stops_count_ || to >= stops_count_) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+    constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+    // best — лучшее время прибытия за любое число раундов, labels[k] — метки раунда k
+    std::vector<double> best(stops_count_, INFINITE_TIME);
+    std::vector<double> previous_best;
+    std::vector<std::vector<Label>> labels(1, std::vector<Label>(stops_count_));
+    std::vector<uint32_t> marked_stops{from};
+    std::vector<bool> is_marked(stops_count_, false);
+    // Для каждой линии — первая позиция, с которой её нужно просматривать в раунде
+    std::vector<uint32_t> first_positions(line_name_ids_.size(), NO_LINE);
+    std::vector<uint32_t> queued_lines;
+    best[from] = 0.0;
+    size_t best_round = 0;
+
+    for (size_t round = 1; !marked_stops.empty(); ++round) {
+        for (const uint32_t stop : marked_stops) {
+            for (uint32_t index = stop_line_offsets_[stop]; index < stop_line_offsets_[stop + 1]; ++index) {
+                const LineStop& line_stop = stop_lines_[index];
+                if (first_positions[line_stop.line] == NO_LINE) {
+                    queued_lines.push_back(line_stop.line);
+                }
+                first_positions[line_stop.line] = std::min(first_positions[line_stop.line], line_stop.position);
+            }
+        }
+        marked_stops.clear();
+        previous_best = best;
+        labels.emplace_back(stops_count_);
+        std::vector<Label>& round_labels = labels.back();
+
+        for (const uint32_t line : queued_lines) {
+            const uint32_t offset = line_offsets_[line];
+            const uint32_t line_size = line_offsets_[line + 1] - offset;
+            std::optional<uint32_t> board_position;
+            double board_time = INFINITE_TIME;
+            for (uint32_t position = first_positions[line]; position < line_size; ++position) {
+                const uint32_t stop = line_stops_[offset + position];
+                double arrival = INFINITE_TIME;
+                if (board_position) {
+                    arrival = board_time + GetRideTime(line, *board_position, position);
+                    if (arrival < best[stop] && arrival < best[to]) {
+                        best[stop] = arrival;
+                        round_labels[stop] = {line, *board_position, position};
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                // Пересадка на эту линию оплачивается ожиданием, как в графовой модели
+                const double transfer_time = previous_best[stop] + line_wait_times_[line];
+                if (transfer_time < arrival) {
+                    board_position = position;
+                    board_time = transfer_time;
+                }
+            }
+            first_positions[line] = NO_LINE;
+        }
+        queued_lines.clear();
+        for (const uint32_t stop : marked_stops) {
+            is_marked[stop] = false;
+        }
+        if (round_labels[to].line != NO_LINE) {
+            best_round = round;
+        }
+    }
+
+    if (best[to] == INFINITE_TIME) {
+        return std::nullopt;
+    }
+    return ReconstructRoute(labels, from, to, best_round);
+}
+
+std::vector<double> RaptorRouter::GetArrivalTimes(uint32_t from, double max_time) const {
+    if (from >= stops_count_) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+    constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+    std::vector<double> best(stops_count_, INFINITE_TIME);
+    std::vector<double> previous_best;
+    std::vector<uint32_t> marked_stops;
+    std::vector<bool> is_marked(stops_count_, false);
+    std::vector<uint32_t> first_positions(line_name_ids_.size(), NO_LINE);
+    std::vector<uint32_t> queued_lines;
+    if (max_time < 0.0) {
+        return best;
+    }
+    best[from] = 0.0;
+    marked_stops.push_back(from);
+
+    while (!marked_stops.empty()) {
+        for (const uint32_t stop : marked_stops) {
+            for (uint32_t index = stop_line_offsets_[stop]; index < stop_line_offsets_[stop + 1]; ++index) {
+                const LineStop& line_stop = stop_lines_[index];
+                if (first_positions[line_stop.line] == NO_LINE) {
+                    queued_lines.push_back(line_stop.line);
+                }
+                first_positions[line_stop.line] = std::min(first_positions[line_stop.line], line_stop.position);
+            }
+        }
+        marked_stops.clear();
+        previous_best = best;
+
+        for (const uint32_t line : queued_lines) {
+            const uint32_t offset = line_offsets_[line];
+            const uint32_t line_size = line_offsets_[line + 1] - offset;
+            std::optional<uint32_t> board_position;
+            double board_time = INFINITE_TIME;
+            for (uint32_t position = first_positions[line]; position < line_size; ++position) {
+                const uint32_t stop = line_stops_[offset + position];
+                double arrival = INFINITE_TIME;
+                if (board_position) {
+                    arrival = board_time + GetRideTime(line, *board_position, position);
+                    if (arrival < best[stop] && arrival <= max_time) {
+                        best[stop] = arrival;
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked_stops.push_back(stop);
+                        }
+                    }
+                }
+                const double transfer_time = previous_best[stop] + line_wait_times_[line];
+                if (transfer_time < arrival) {
+                    board_position = position;
+                    board_time = transfer_time;
+                }
+            }
+            first_positions[line] = NO_LINE;
+        }
+        queued_lines.clear();
+        for (const uint32_t stop : marked_stops) {
+            is_marked[stop] = false;
+        }
+    }
+    return best;
+}
+
+std::vector<RaptorRouter::Leg> RaptorRouter::ReconstructRoute(const std::vector<std::vector<Label>>& labels,
+                                                              uint32_t from, uint32_t to, size_t round) const {
+    std::vector<Leg> legs;
+    uint32_t stop = to;
+    while (stop != from) {
+        // Время остановки взято из последнего раунда, в котором она улучшалась
+        while (labels[round][stop].line == NO_LINE) {
+            --round;
+        }
+        const Label& label = labels[round][stop];
+        const uint32_t offset = line_offsets_[label.line];
+        const uint32_t board_stop = line_stops_[offset + label.board_position];
+        legs.push_back({line_name_ids_[label.line],
+                        board_stop,
+                        stop,
+                        label.alight_position - label.board_position,
+                        line_wait_times_[label.line],
+                        GetRideTime(label.line, label.board_position, label.alight_position)});
+        stop = board_stop;
+        --round;
+    }
+    std::reverse(legs.begin(), legs.end());
+    return legs;
+}
+
+}  // namespace transport
@@ -4,8 +4,12 @@ std::optional<transport::BusStat> RequestHandler::GetBusStat(const std::string_v
     return catalogue_.GetBusStat(bus_number);
 }
 
-const std::set<std::string> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
-    return catalogue_.FindStop(stop_name)->buses_by_stop;
+std::vector<std::string_view> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
+    std::vector<std::string_view> buses;
+    for (const transport::BusId bus_id : catalogue_.FindStop(stop_name)->buses_by_stop) {
+        buses.push_back(catalogue_.GetBus(bus_id)->number);
+    }
+    return buses;
 }
 
 bool RequestHandler::IsBusNumber(const std::string_view bus_number) const {
@@ -16,10 +20,22 @@ bool RequestHandler::IsStopName(const std::string_view stop_name) const {
     return catalogue_.FindStop(stop_name);
 }
 
-const RequestHandler::Route RequestHandler::GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-    return transport_router_.FindRoute(stop_from, stop_to);
+std::vector<transport::ReachableStop> RequestHandler::GetReachableStops(const std::string_view stop_from, double max_time) const {
+    return transport_router_.FindReachableStops(stop_from, max_time);
+}
+
+std::vector<double> RequestHandler::GetTravelTimes(const std::vector<std::string_view>& origins, const std::vector<std::string_view>& destinations) const {
+    return transport_router_.FindTravelTimes(origins, destinations);
+}
+
+std::vector<std::optional<RequestHandler::RouteView>> RequestHandler::GetOptimalRouteViews(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const {
+    return transport_router_.FindRouteViews(stop_pairs);
+}
+
+std::string_view RequestHandler::GetRouteItemName(const graph::Edge<double>& edge) const {
+    return transport_router_.GetEdgeName(edge);
 }
 
 svg::Document RequestHandler::RenderMap() const {
-    return renderer_.GetSVG(catalogue_.GetSortedAllBuses());
+    return renderer_.GetSVG(catalogue_);
 }
\ No newline at end of file
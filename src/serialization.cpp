@@ -1,6 +1,8 @@
 #include "serialization.h"
 
 #include "fstream"
+#include <algorithm>
+#include <cstring>
 
 namespace serialization {
 
@@ -14,6 +16,9 @@ void Serialize(transport::Catalogue& tc, const renderer::MapRenderer& render, co
     SerializeStopIds(router, proto_tc);
     SerializeRouterSettings(router, proto_tc);
     SerializeGraph(router, proto_tc);
+    SerializeHierarchy(router, proto_tc);
+    SerializeRoutesTable(router, proto_tc);
+    SerializeLandmarks(router, proto_tc);
 
 	proto_tc.SerializeToOstream(&out);
 }
@@ -39,40 +44,45 @@ std::tuple<transport::Catalogue, renderer::MapRenderer> Deserialize(const proto_
 
 
 void SerializeStops(const transport::Catalogue& tc, proto_transport::TransportCatalogue& proto_tc) {
-    const auto all_stops = tc.GetSortedAllStops();
-    for (const auto& stop : all_stops) {
+    for (const transport::StopId stop_id : tc.GetSortedStopIds()) {
+        const transport::Stop* stop = tc.GetStop(stop_id);
         proto_transport::Stop proto_stop;
-        proto_stop.set_name(stop.second->name);
-        proto_stop.mutable_coordinates()->set_lat(stop.second->coordinates.lat);
-        proto_stop.mutable_coordinates()->set_lng(stop.second->coordinates.lng);
-        for (const auto& bus : stop.second->buses_by_stop) {
-			proto_stop.add_buses_by_stop(bus);
+        proto_stop.set_name(std::string(stop->name));
+        proto_stop.mutable_coordinates()->set_lat(stop->coordinates.lat);
+        proto_stop.mutable_coordinates()->set_lng(stop->coordinates.lng);
+        for (const transport::BusId bus_id : stop->buses_by_stop) {
+			proto_stop.add_buses_by_stop(std::string(tc.GetBus(bus_id)->number));
 		}
 		*proto_tc.add_stops() = std::move(proto_stop);
     }
 }
     
 void SerializeStopDistances(const transport::Catalogue& tc, proto_transport::TransportCatalogue& proto_tc) {
-    const auto stop_distances = tc.GetStopDistances();
-    for (const auto& [from_to, dist] : stop_distances) {
+    for (const auto& road_distance : tc.GetStopDistances()) {
         proto_transport::StopDistances proto_distances;
-        proto_distances.set_from(from_to.first->name);
-        proto_distances.set_to(from_to.second->name);
-        proto_distances.set_distance(dist);
+        proto_distances.set_from(std::string(tc.GetStop(road_distance.from)->name));
+        proto_distances.set_to(std::string(tc.GetStop(road_distance.to)->name));
+        proto_distances.set_distance(road_distance.distance);
         
         *proto_tc.add_stop_distances() = std::move(proto_distances);
     }
 }
     
 void SerializeBuses(const transport::Catalogue& tc, proto_transport::TransportCatalogue& proto_tc) {
-    const auto all_buses = tc.GetSortedAllBuses();
-    for (const auto& bus : all_buses) {
+    for (const transport::BusId bus_id : tc.GetSortedBusIds()) {
+        const transport::Bus* bus = tc.GetBus(bus_id);
         proto_transport::Bus proto_bus;
-        proto_bus.set_number(bus.second->number);
-        for (const auto* stop : bus.second->stops) {
-			*proto_bus.mutable_stops()->Add() = stop->name;
+        proto_bus.set_number(std::string(bus->number));
+        for (const transport::StopId stop_id : bus->stops) {
+			*proto_bus.mutable_stops()->Add() = std::string(tc.GetStop(stop_id)->name);
 		}
-		proto_bus.set_is_circle(bus.second->is_circle);
+		proto_bus.set_is_circle(bus->is_circle);
+        const transport::BusStat& bus_stat = tc.GetBusStats().at(bus->id);
+        proto_transport::BusStat& proto_bus_stat = *proto_bus.mutable_stat();
+        proto_bus_stat.set_stops_count(static_cast<int32_t>(bus_stat.stops_count));
+        proto_bus_stat.set_unique_stops_count(static_cast<int32_t>(bus_stat.unique_stops_count));
+        proto_bus_stat.set_route_length(bus_stat.route_length);
+        proto_bus_stat.set_curvature(bus_stat.curvature);
 		*proto_tc.add_buses() = std::move(proto_bus);
     }
 }
@@ -146,6 +156,15 @@ void SerializeRouterSettings(const transport::TransportRouter& router, proto_tra
     proto_router::RoutingSettings proto_router_settings;
     proto_router_settings.set_wait_time(settings.bus_wait_time_);
     proto_router_settings.set_velocity(settings.bus_velocity_);
+    proto_router_settings.set_router_type(static_cast<proto_router::RouterType>(settings.router_type_));
+    proto_router_settings.set_threads_count(static_cast<uint32_t>(settings.threads_count_));
+    proto_router_settings.set_route_cache_capacity(settings.route_cache_capacity_);
+    proto_router_settings.set_graph_model(static_cast<proto_router::GraphModel>(settings.graph_model_));
+    proto_router_settings.set_landmarks_count(static_cast<uint32_t>(settings.landmarks_count_));
+    proto_router_settings.set_vertex_order(static_cast<proto_router::VertexOrder>(settings.vertex_order_));
+    for (const auto& [bus_number, headway] : settings.bus_headways_) {
+        (*proto_router_settings.mutable_bus_headways())[bus_number] = headway;
+    }
     *proto_tc.mutable_router()->mutable_router_settings() = std::move(proto_router_settings);
 }
 
@@ -155,19 +174,18 @@ void SerializeGraph(const transport::TransportRouter& router, proto_transport::T
     for (int i = 0; i < graph.GetEdgeCount(); ++i) {
         proto_graph::Edge proto_edge;
         const auto& edge = graph.GetEdge(i);
-        proto_edge.set_name(edge.name);
+        proto_edge.set_name_id(edge.name_id);
         proto_edge.set_quality(edge.quality);
         proto_edge.set_from(edge.from);
         proto_edge.set_to(edge.to);
         proto_edge.set_weight(edge.weight);
         *proto_tc.mutable_router()->mutable_graph()->add_edges() = std::move(proto_edge);
     }
-    for (int i = 0; i < graph.GetVertexCount(); ++i) {
-        proto_graph::Vertex vertex;
-        for (const auto& id : graph.GetIncidentEdges(i)) {
-            vertex.add_edge_id(id);
-        }
-        *proto_tc.mutable_router()->mutable_graph()->add_vertexes() = vertex;
+    const auto& ride_times = data.GetRideTimes(router);
+    proto_tc.mutable_router()->mutable_ride_times()->Add(ride_times.begin(), ride_times.end());
+    proto_tc.mutable_router()->mutable_graph()->set_vertex_count(static_cast<uint32_t>(graph.GetVertexCount()));
+    for (graph::NameId name_id = 0; name_id < graph.GetNameCount(); ++name_id) {
+        proto_tc.mutable_router()->mutable_graph()->add_names(graph.GetName(name_id));
     }
 }
 
@@ -182,7 +200,67 @@ void SerializeStopIds(const transport::TransportRouter& router, proto_transport:
     }
 }
 
+void SerializeHierarchy(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc) {
+    transport::GetRouteData data;
+    const Hierarchy* hierarchy = data.GetHierarchy(router);
+    if (!hierarchy) {
+        return;
+    }
+    const auto& index = hierarchy->GetIndex();
+    proto_graph::ContractionHierarchy& proto_hierarchy = *proto_tc.mutable_router()->mutable_contraction_hierarchy();
+    proto_hierarchy.mutable_ranks()->Reserve(static_cast<int>(index.ranks.size()));
+    for (const auto rank : index.ranks) {
+        proto_hierarchy.add_ranks(static_cast<uint32_t>(rank));
+    }
+    proto_hierarchy.mutable_arcs()->Reserve(static_cast<int>(index.arcs.size()));
+    for (const auto& arc : index.arcs) {
+        proto_graph::ContractionArc& proto_arc = *proto_hierarchy.add_arcs();
+        proto_arc.set_from(arc.from);
+        proto_arc.set_to(arc.to);
+        proto_arc.set_weight(arc.weight);
+        if (arc.IsShortcut()) {
+            proto_arc.set_is_shortcut(true);
+            proto_arc.set_first(arc.first);
+            proto_arc.set_second(arc.second);
+        }
+        else {
+            proto_arc.set_edge_id(arc.edge_id);
+        }
+    }
+}
+
+void SerializeRoutesTable(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc) {
+    transport::GetRouteData data;
+    const graph::Router<double>* all_pairs_router = data.GetRouter(router);
+    if (!all_pairs_router) {
+        return;
+    }
+    const RoutesTable& routes_table = all_pairs_router->GetRoutesTable();
+    proto_graph::RoutesTable& proto_routes_table = *proto_tc.mutable_router()->mutable_routes_table();
+    proto_routes_table.set_vertex_count(static_cast<uint32_t>(data.GetGraph(router).GetVertexCount()));
+    proto_routes_table.set_weights(reinterpret_cast<const char*>(routes_table.weights.data()),
+                                   routes_table.weights.size() * sizeof(double));
+    proto_routes_table.set_prev_edges(reinterpret_cast<const char*>(routes_table.prev_edges.data()),
+                                      routes_table.prev_edges.size() * sizeof(uint32_t));
+}
+
+void SerializeLandmarks(const transport::TransportRouter& router, proto_transport::TransportCatalogue& proto_tc) {
+    transport::GetRouteData data;
+    const transport::TransportRouter::AltRouter* alt_router = data.GetAltRouter(router);
+    if (!alt_router) {
+        return;
+    }
+    const Landmarks& landmarks = alt_router->GetLandmarks();
+    proto_graph::Landmarks& proto_landmarks = *proto_tc.mutable_router()->mutable_landmarks();
+    proto_landmarks.mutable_vertices()->Add(landmarks.vertices.begin(), landmarks.vertices.end());
+    proto_landmarks.set_from_landmarks(reinterpret_cast<const char*>(landmarks.from_landmarks.data()),
+                                       landmarks.from_landmarks.size() * sizeof(double));
+    proto_landmarks.set_to_landmarks(reinterpret_cast<const char*>(landmarks.to_landmarks.data()),
+                                     landmarks.to_landmarks.size() * sizeof(double));
+}
+
 void DeserializeStops(transport::Catalogue& tc, const proto_transport::TransportCatalogue& proto_tc) {
+    tc.Reserve(proto_tc.stops_size(), proto_tc.buses_size());
     for (size_t i = 0; i < proto_tc.stops_size(); ++i) {
 		const proto_transport::Stop& proto_stop = proto_tc.stops(i);
 		tc.AddStop(proto_stop.name(), { proto_stop.coordinates().lat(), proto_stop.coordinates().lng() });
@@ -199,6 +277,8 @@ void DeserializeStopDistances(transport::Catalogue& tc, const proto_transport::T
 }
     
 void DeserializeBuses(transport::Catalogue& tc, const proto_transport::TransportCatalogue& proto_tc) {
+    std::vector<transport::BusStat> bus_stats;
+    bus_stats.reserve(proto_tc.buses_size());
     for (size_t i = 0; i < proto_tc.buses_size(); ++i) {
         const proto_transport::Bus& proto_bus = proto_tc.buses(i);
         std::vector<const transport::Stop*> stops(proto_bus.stops_size());
@@ -206,7 +286,19 @@ void DeserializeBuses(transport::Catalogue& tc, const proto_transport::Transport
 			stops[j] = tc.FindStop(proto_bus.stops(j));
 		}
         tc.AddRoute(proto_bus.number(), stops, proto_bus.is_circle());
+        if (proto_bus.has_stat()) {
+            const proto_transport::BusStat& proto_bus_stat = proto_bus.stat();
+            bus_stats.push_back({ static_cast<size_t>(proto_bus_stat.stops_count()),
+                                  static_cast<size_t>(proto_bus_stat.unique_stops_count()),
+                                  proto_bus_stat.route_length(),
+                                  proto_bus_stat.curvature() });
+        }
+    }
+    // Номера автобусов в каталоге совпадают с их порядком в базе; неполная таблица не годится
+    if (bus_stats.size() != static_cast<size_t>(proto_tc.buses_size())) {
+        bus_stats.clear();
     }
+    tc.Finalize(std::max<size_t>(proto_tc.router().router_settings().threads_count(), 1), std::move(bus_stats));
 }
 
 renderer::MapRenderer DeserializeRenderSettings(renderer::RenderSettings& render_settings, const proto_transport::TransportCatalogue& proto_tc) {
@@ -245,22 +337,30 @@ svg::Color DeserializeColor(const proto_svg::Color& proto_color) {
     throw std::runtime_error("Error deserialized color");
 }
 
-transport::TransportRouter DeserializeRouter(const proto_transport::TransportCatalogue& proto_tc) {
-    
-    transport::TransportRouter router;
-    transport::RoutingSettings settings = DeserializeRoutingSettings(proto_tc);
-    StopById stop_ids = DeserializeStopById(proto_tc);
-    Graph graph = DeserializeGraph(proto_tc);
-    router.SetRoutingSettings(settings);
-    router.SetStopByIds(stop_ids);
-    router.SetGraph(std::move(graph));
-    return router;
+transport::TransportRouter DeserializeRouter(const proto_transport::TransportCatalogue& proto_tc, const transport::Catalogue& tc) {
+    return { DeserializeRoutingSettings(proto_tc),
+             tc,
+             DeserializeGraph(proto_tc),
+             DeserializeStopById(proto_tc),
+             { DeserializeRoutesTable(proto_tc),
+               DeserializeHierarchy(proto_tc),
+               { proto_tc.router().ride_times().begin(), proto_tc.router().ride_times().end() },
+               DeserializeLandmarks(proto_tc) } };
 }
 
 transport::RoutingSettings DeserializeRoutingSettings(const proto_transport::TransportCatalogue& proto_tc) {
     int bus_wait_time = proto_tc.router().router_settings().wait_time();
     double velocity = proto_tc.router().router_settings().velocity();
-    return { bus_wait_time, velocity };
+    auto router_type = static_cast<transport::RouterType>(proto_tc.router().router_settings().router_type());
+    size_t threads_count = std::max<size_t>(proto_tc.router().router_settings().threads_count(), 1);
+    size_t route_cache_capacity = proto_tc.router().router_settings().route_cache_capacity();
+    std::map<std::string, double> bus_headways(proto_tc.router().router_settings().bus_headways().begin(),
+                                               proto_tc.router().router_settings().bus_headways().end());
+    auto graph_model = static_cast<transport::GraphModel>(proto_tc.router().router_settings().graph_model());
+    size_t landmarks_count = std::max<size_t>(proto_tc.router().router_settings().landmarks_count(), 1);
+    auto vertex_order = static_cast<transport::VertexOrder>(proto_tc.router().router_settings().vertex_order());
+    return { bus_wait_time, velocity, router_type, threads_count, route_cache_capacity, std::move(bus_headways), graph_model,
+             landmarks_count, vertex_order };
 }
 
 StopById DeserializeStopById(const proto_transport::TransportCatalogue& proto_tc) {
@@ -273,28 +373,76 @@ StopById DeserializeStopById(const proto_transport::TransportCatalogue& proto_tc
 
 Graph DeserializeGraph(const proto_transport::TransportCatalogue& proto_tc) {
     const proto_graph::Graph& proto_graph = proto_tc.router().graph();
-    graph::DirectedWeightedGraph<double> graph;
-    std::vector<graph::Edge<double>> edges(proto_graph.edges_size());
-    std::vector<std::vector<graph::EdgeId>> incidence_list(proto_graph.vertexes_size());
-    for (int i = 0; i < edges.size(); ++i) {
-        const proto_graph::Edge& proto_edge = proto_graph.edges(i);
-        edges[i] = { proto_edge.name(),
-                     static_cast<size_t>(proto_edge.quality()),
-                     static_cast<size_t>(proto_edge.from()),
-                     static_cast<size_t>(proto_edge.to()),
-                     proto_edge.weight() };
-        
+    graph::DirectedWeightedGraph<double> graph(proto_graph.vertex_count());
+    for (const auto& name : proto_graph.names()) {
+        graph.AddName(name);
     }
-    for (size_t i = 0; i < incidence_list.size(); ++i) {
-        const proto_graph::Vertex& proto_vertex = proto_graph.vertexes(i);
-        incidence_list[i].reserve(proto_vertex.edge_id_size());
-        for (const auto& id : proto_vertex.edge_id()) {
-            incidence_list[i].push_back(id);
-        }
+    for (const proto_graph::Edge& proto_edge : proto_graph.edges()) {
+        graph.AddEdge({ proto_edge.name_id(),
+                        static_cast<size_t>(proto_edge.quality()),
+                        static_cast<size_t>(proto_edge.from()),
+                        static_cast<size_t>(proto_edge.to()),
+                        proto_edge.weight() });
     }
-    graph.SetEdges(edges);
-    graph.SetIncidence(incidence_list);
+    // Рёбра сохранены в порядке CSR, поэтому номера при заморозке не меняются
+    graph.Freeze();
     return graph;
 }
 
-}
\ No newline at end of file
+Hierarchy::Index DeserializeHierarchy(const proto_transport::TransportCatalogue& proto_tc) {
+    const proto_graph::ContractionHierarchy& proto_hierarchy = proto_tc.router().contraction_hierarchy();
+    Hierarchy::Index index;
+    index.ranks.assign(proto_hierarchy.ranks().begin(), proto_hierarchy.ranks().end());
+    index.arcs.reserve(proto_hierarchy.arcs_size());
+    for (const auto& proto_arc : proto_hierarchy.arcs()) {
+        Hierarchy::Arc arc{ proto_arc.from(), proto_arc.to(), proto_arc.weight() };
+        if (proto_arc.is_shortcut()) {
+            arc.first = proto_arc.first();
+            arc.second = proto_arc.second();
+        }
+        else {
+            arc.edge_id = proto_arc.edge_id();
+        }
+        index.arcs.push_back(arc);
+    }
+    return index;
+}
+
+RoutesTable DeserializeRoutesTable(const proto_transport::TransportCatalogue& proto_tc) {
+    const proto_graph::RoutesTable& proto_routes_table = proto_tc.router().routes_table();
+    // Таблица, посчитанная для другого графа, не годится, даже если размеры случайно сошлись
+    if (!proto_routes_table.weights().empty()
+        && proto_routes_table.vertex_count() != proto_tc.router().graph().vertex_count()) {
+        throw std::runtime_error("Routes table does not match the graph");
+    }
+    // Размер таблицы — сумма квадратов размеров компонент; с графом её сверяет сам Router
+    const size_t cells_count = proto_routes_table.weights().size() / sizeof(double);
+    if (proto_routes_table.weights().size() != cells_count * sizeof(double)
+        || proto_routes_table.prev_edges().size() != cells_count * sizeof(uint32_t)) {
+        throw std::runtime_error("Error deserialized routes table");
+    }
+    RoutesTable routes_table;
+    routes_table.weights.resize(cells_count);
+    routes_table.prev_edges.resize(cells_count);
+    std::memcpy(routes_table.weights.data(), proto_routes_table.weights().data(), proto_routes_table.weights().size());
+    std::memcpy(routes_table.prev_edges.data(), proto_routes_table.prev_edges().data(), proto_routes_table.prev_edges().size());
+    return routes_table;
+}
+
+Landmarks DeserializeLandmarks(const proto_transport::TransportCatalogue& proto_tc) {
+    const proto_graph::Landmarks& proto_landmarks = proto_tc.router().landmarks();
+    const size_t cells_count = static_cast<size_t>(proto_tc.router().graph().vertex_count()) * proto_landmarks.vertices_size();
+    if (proto_landmarks.from_landmarks().size() != cells_count * sizeof(double)
+        || proto_landmarks.to_landmarks().size() != cells_count * sizeof(double)) {
+        throw std::runtime_error("Error deserialized landmarks");
+    }
+    Landmarks landmarks;
+    landmarks.vertices.assign(proto_landmarks.vertices().begin(), proto_landmarks.vertices().end());
+    landmarks.from_landmarks.resize(cells_count);
+    landmarks.to_landmarks.resize(cells_count);
+    std::memcpy(landmarks.from_landmarks.data(), proto_landmarks.from_landmarks().data(), proto_landmarks.from_landmarks().size());
+    std::memcpy(landmarks.to_landmarks.data(), proto_landmarks.to_landmarks().data(), proto_landmarks.to_landmarks().size());
+    return landmarks;
+}
+
+}
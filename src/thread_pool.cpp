@@ -0,0 +1,89 @@
+#include "thread_pool.h"
+
+namespace concurrency {
+
+ThreadPool::ThreadPool(size_t threads_count) {
+    for (size_t i = 1; i < threads_count; ++i) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    job_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadsCount() const {
+    return workers_.size() + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (workers_.empty() || count <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index);
+        }
+        return;
+    }
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        task_count_ = count;
+        next_index_ = 0;
+        error_ = nullptr;
+        active_workers_ = workers_.size();
+        ++generation_;
+    }
+    job_ready_.notify_all();
+    RunTasks();
+
+    std::unique_lock lock(mutex_);
+    job_done_.wait(lock, [this] { return active_workers_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void ThreadPool::WorkerLoop() {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            job_ready_.wait(lock, [this, seen_generation] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        RunTasks();
+        {
+            std::lock_guard lock(mutex_);
+            if (--active_workers_ == 0) {
+                job_done_.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::RunTasks() {
+    for (size_t index = next_index_++; index < task_count_; index = next_index_++) {
+        try {
+            (*task_)(index);
+        }
+        catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            next_index_ = task_count_;
+        }
+    }
+}
+
+}  // namespace concurrency
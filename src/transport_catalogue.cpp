@@ -1,22 +1,102 @@
 #include "transport_catalogue.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
 namespace transport {
 
+void Catalogue::Reserve(size_t stops_count, size_t buses_count) {
+    stopname_to_stop_.reserve(stopname_to_stop_.size() + stops_count);
+    busname_to_bus_.reserve(busname_to_bus_.size() + buses_count);
+}
+
 void Catalogue::AddStop(std::string_view stop_name, const geo::Coordinates coordinates) {
-    all_stops_.push_back({ std::string(stop_name), coordinates, {} });
+    all_stops_.push_back({ names_.Add(stop_name), coordinates, static_cast<StopId>(all_stops_.size()) });
     stopname_to_stop_[all_stops_.back().name] = &all_stops_.back();
 }
 
 void Catalogue::AddRoute(std::string_view bus_number, const std::vector<const Stop*>& stops, bool is_circle) {
-    all_buses_.push_back({ std::string(bus_number), stops, is_circle });
+    std::vector<StopId> stop_ids(stops.size());
+    for (size_t i = 0; i < stops.size(); ++i) {
+        stop_ids[i] = stops[i]->id;
+    }
+    all_buses_.push_back({ names_.Add(bus_number), static_cast<BusId>(all_buses_.size()), std::move(stop_ids), is_circle });
     busname_to_bus_[all_buses_.back().number] = &all_buses_.back();
-    for (const auto& route_stop : stops) {
-        for (auto& stop_ : all_stops_) {
-            if (stop_.name == route_stop->name) {
-                stop_.buses_by_stop.insert(std::string(bus_number));
+}
+
+void Catalogue::Finalize(size_t threads_count, std::vector<BusStat> bus_stats) {
+    BuildDistanceIndex();
+
+    sorted_bus_ids_.resize(all_buses_.size());
+    for (BusId bus_id = 0; bus_id < sorted_bus_ids_.size(); ++bus_id) {
+        sorted_bus_ids_[bus_id] = bus_id;
+    }
+    std::sort(sorted_bus_ids_.begin(), sorted_bus_ids_.end(), [this](BusId lhs, BusId rhs) {
+        return all_buses_[lhs].number < all_buses_[rhs].number;
+    });
+    sorted_stop_ids_.resize(all_stops_.size());
+    for (StopId stop_id = 0; stop_id < sorted_stop_ids_.size(); ++stop_id) {
+        sorted_stop_ids_[stop_id] = stop_id;
+    }
+    std::sort(sorted_stop_ids_.begin(), sorted_stop_ids_.end(), [this](StopId lhs, StopId rhs) {
+        return all_stops_[lhs].name < all_stops_[rhs].name;
+    });
+
+    // Автобусы обходятся по возрастанию номеров, тогда участок каждой остановки сразу упорядочен
+
+    // Последний автобус, записанный у остановки, отсекает повторные заходы на неё
+    constexpr BusId NO_BUS = std::numeric_limits<BusId>::max();
+    std::vector<BusId> last_buses(all_stops_.size(), NO_BUS);
+    std::vector<size_t> offsets(all_stops_.size() + 1, 0);
+    for (const BusId bus_id : sorted_bus_ids_) {
+        for (const StopId stop_id : all_buses_[bus_id].stops) {
+            if (last_buses[stop_id] != bus_id) {
+                last_buses[stop_id] = bus_id;
+                ++offsets[stop_id + 1];
             }
         }
     }
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+
+    stop_bus_ids_.assign(offsets.back(), 0);
+    std::vector<size_t> positions(offsets.begin(), offsets.end() - 1);
+    std::fill(last_buses.begin(), last_buses.end(), NO_BUS);
+    for (const BusId bus_id : sorted_bus_ids_) {
+        for (const StopId stop_id : all_buses_[bus_id].stops) {
+            if (last_buses[stop_id] != bus_id) {
+                last_buses[stop_id] = bus_id;
+                stop_bus_ids_[positions[stop_id]++] = bus_id;
+            }
+        }
+    }
+    for (Stop& stop : all_stops_) {
+        stop.buses_by_stop = { stop_bus_ids_.data() + offsets[stop.id], stop_bus_ids_.data() + offsets[stop.id + 1] };
+    }
+
+    if (bus_stats.size() == all_buses_.size()) {
+        bus_stats_ = std::move(bus_stats);
+        return;
+    }
+    // Уже посчитанные автобусы не пересчитываются, в том числе при update_base
+    const size_t first_bus_id = std::min(bus_stats_.size(), all_buses_.size());
+    const size_t new_buses_count = all_buses_.size() - first_bus_id;
+    bus_stats_.resize(all_buses_.size());
+    // Каждая задача пишет только свою ячейку, а каталог на время расчёта не меняется
+    const auto compute_bus_stat = [this, first_bus_id](size_t index) {
+        bus_stats_[first_bus_id + index] = ComputeBusStat(all_buses_[first_bus_id + index]);
+    };
+    if (threads_count <= 1 || new_buses_count < PARALLEL_BUS_STATS_MIN_COUNT) {
+        for (size_t index = 0; index < new_buses_count; ++index) {
+            compute_bus_stat(index);
+        }
+        return;
+    }
+    concurrency::ThreadPool pool(std::min(threads_count, new_buses_count));
+    pool.ParallelFor(new_buses_count, compute_bus_stat);
 }
 
 const Bus* Catalogue::FindRoute(std::string_view bus_number) const {
@@ -27,64 +107,123 @@ const Stop* Catalogue::FindStop(std::string_view stop_name) const {
     return stopname_to_stop_.count(stop_name) ? stopname_to_stop_.at(stop_name) : nullptr;
 }
 
-size_t Catalogue::UniqueStopsCount(std::string_view bus_number) const {
-    std::unordered_set<std::string_view> unique_stops;
-    for (const auto& stop : busname_to_bus_.at(bus_number)->stops) {
-        unique_stops.insert(stop->name);
-    }
-    return unique_stops.size();
+const Stop* Catalogue::GetStop(StopId stop_id) const {
+    return &all_stops_.at(stop_id);
+}
+
+const Bus* Catalogue::GetBus(BusId bus_id) const {
+    return &all_buses_.at(bus_id);
+}
+
+size_t Catalogue::UniqueStopsCount(const Bus& bus) const {
+    std::vector<StopId> unique_stops = bus.stops;
+    std::sort(unique_stops.begin(), unique_stops.end());
+    return std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
 }
 
 void Catalogue::SetDistance(const Stop* from, const Stop* to, const int distance) {
-    stop_distances_[{from, to}] = distance;
+    road_distances_.push_back({ from->id, to->id, distance });
 }
 
 int Catalogue::GetDistance(const Stop* from, const Stop* to) const {
-    if (stop_distances_.count({ from, to })) {
-        return stop_distances_.at({ from, to });
+    if (from->id + 1 >= distance_offsets_.size()) {
+        return 0;
     }
-    else if (stop_distances_.count({ to, from })) {
-        return stop_distances_.at({ to, from });
-    } 
-    else return 0;
+    const auto begin = distance_neighbours_.begin() + distance_offsets_[from->id];
+    const auto end = distance_neighbours_.begin() + distance_offsets_[from->id + 1];
+    const auto it = std::lower_bound(begin, end, to->id, [](const Neighbour& neighbour, StopId stop_id) {
+        return neighbour.stop_id < stop_id;
+    });
+    return it != end && it->stop_id == to->id ? it->distance : 0;
 }
-    
-const std::map<std::string_view, const Bus*> Catalogue::GetSortedAllBuses() const {
-    std::map<std::string_view, const Bus*> result;
-    for (const auto& bus : busname_to_bus_) {
-        result.emplace(bus);
+
+void Catalogue::BuildDistanceIndex() {
+    // Из повторов одной пары остаётся последний: устойчивая сортировка сохраняет порядок вызовов
+    std::stable_sort(road_distances_.begin(), road_distances_.end(), [](const RoadDistance& lhs, const RoadDistance& rhs) {
+        return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+    });
+    std::vector<RoadDistance> unique_distances;
+    unique_distances.reserve(road_distances_.size());
+    for (const RoadDistance& road_distance : road_distances_) {
+        if (!unique_distances.empty() && unique_distances.back().from == road_distance.from
+            && unique_distances.back().to == road_distance.to) {
+            unique_distances.back() = road_distance;
+        }
+        else {
+            unique_distances.push_back(road_distance);
+        }
     }
-    return result;
-}
-    
-const std::map<std::string_view, const Stop*> Catalogue::GetSortedAllStops() const {
-    std::map<std::string_view, const Stop*> result;
-    for (const auto& stop : stopname_to_stop_) {
-        result.emplace(stop);
+    road_distances_ = std::move(unique_distances);
+
+    // Каждое расстояние даёт прямую запись и запасную обратную; при равных концах прямая
+    // идёт первой и вытесняет запасную
+    struct Entry {
+        RoadDistance road_distance;
+        bool is_reverse;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(road_distances_.size() * 2);
+    for (const RoadDistance& road_distance : road_distances_) {
+        entries.push_back({ road_distance, false });
+        entries.push_back({ { road_distance.to, road_distance.from, road_distance.distance }, true });
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return std::tie(lhs.road_distance.from, lhs.road_distance.to, lhs.is_reverse)
+            < std::tie(rhs.road_distance.from, rhs.road_distance.to, rhs.is_reverse);
+    });
+
+    distance_offsets_.assign(all_stops_.size() + 1, 0);
+    distance_neighbours_.clear();
+    distance_neighbours_.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const RoadDistance& road_distance = entries[i].road_distance;
+        if (i > 0 && entries[i - 1].road_distance.from == road_distance.from
+            && entries[i - 1].road_distance.to == road_distance.to) {
+            continue;
+        }
+        distance_neighbours_.push_back({ road_distance.to, road_distance.distance });
+        ++distance_offsets_[road_distance.from + 1];
+    }
+    for (size_t i = 1; i < distance_offsets_.size(); ++i) {
+        distance_offsets_[i] += distance_offsets_[i - 1];
     }
-    return result;
 }
     
+Catalogue::BusIdRange Catalogue::GetSortedBusIds() const {
+    return ranges::AsRange(sorted_bus_ids_);
+}
+
+Catalogue::StopIdRange Catalogue::GetSortedStopIds() const {
+    return ranges::AsRange(sorted_stop_ids_);
+}
+
 std::optional<BusStat> Catalogue::GetBusStat(const std::string_view bus_number) const {
-    BusStat bus_stat{};
     const Bus* bus = FindRoute(bus_number);
-
     if (!bus) {
         throw std::invalid_argument("bus not found");
     }
-    if (bus->is_circle) {
-        bus_stat.stops_count = bus->stops.size();
+    return bus->id < bus_stats_.size() ? bus_stats_[bus->id] : ComputeBusStat(*bus);
+}
+
+const std::vector<BusStat>& Catalogue::GetBusStats() const {
+    return bus_stats_;
+}
+
+BusStat Catalogue::ComputeBusStat(const Bus& bus) const {
+    BusStat bus_stat{};
+    if (bus.is_circle) {
+        bus_stat.stops_count = bus.stops.size();
     } else {
-        bus_stat.stops_count = bus->stops.size() * 2 - 1;
+        bus_stat.stops_count = bus.stops.size() * 2 - 1;
     }
 
     int route_length = 0;
     double geographic_length = 0.0;
 
-    for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
-        auto from = bus->stops[i];
-        auto to = bus->stops[i + 1];
-        if (bus->is_circle) {
+    for (size_t i = 0; i < bus.stops.size() - 1; ++i) {
+        const Stop* from = GetStop(bus.stops[i]);
+        const Stop* to = GetStop(bus.stops[i + 1]);
+        if (bus.is_circle) {
             route_length += GetDistance(from, to);
             geographic_length += geo::ComputeDistance(from->coordinates,
                 to->coordinates);
@@ -96,15 +235,15 @@ std::optional<BusStat> Catalogue::GetBusStat(const std::string_view bus_number)
         }
     }
 
-    bus_stat.unique_stops_count = UniqueStopsCount(bus_number);
+    bus_stat.unique_stops_count = UniqueStopsCount(bus);
     bus_stat.route_length = route_length;
     bus_stat.curvature = route_length / geographic_length;
 
     return bus_stat;
 }
     
-std::unordered_map<std::pair<const Stop*, const Stop*>, int, Catalogue::StopDistancesHasher> Catalogue::GetStopDistances() const {
-    return stop_distances_;
+const std::vector<Catalogue::RoadDistance>& Catalogue::GetStopDistances() const {
+    return road_distances_;
 }
 
 }
\ No newline at end of file
@@ -1,98 +1,730 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
 namespace transport {
 
     const TransportRouter::Route TransportRouter::FindRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-        const auto& routing = router_->BuildRoute(stop_ids_.at(std::string(stop_from)), stop_ids_.at(std::string(stop_to)));
+        const graph::VertexId from = GetStopVertex(stop_from);
+        const graph::VertexId to = GetStopVertex(stop_to);
+        const uint64_t cache_key = GetRouteCacheKey(from, to);
+        if (route_cache_) {
+            if (auto cached = route_cache_->Get(cache_key)) {
+                return std::move(*cached);
+            }
+        }
+
+        Route route_by_id = ComputeRoute(from, to);
+        if (route_cache_) {
+            route_cache_->Put(cache_key, route_by_id);
+        }
+        return route_by_id;
+    }
+
+    std::vector<TransportRouter::Route> TransportRouter::FindRoutes(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const {
+        std::vector<Route> routes(stop_pairs.size());
+        // Для каждой начальной вершины — номера ещё не найденных пар
+        std::map<graph::VertexId, std::vector<size_t>> pairs_by_origin;
+        std::vector<graph::VertexId> targets(stop_pairs.size());
+        for (size_t i = 0; i < stop_pairs.size(); ++i) {
+            const graph::VertexId from = GetStopVertex(stop_pairs[i].first);
+            targets[i] = GetStopVertex(stop_pairs[i].second);
+            if (route_cache_) {
+                const uint64_t cache_key = GetRouteCacheKey(from, targets[i]);
+                if (auto cached = route_cache_->Get(cache_key)) {
+                    routes[i] = std::move(*cached);
+                    continue;
+                }
+            }
+            pairs_by_origin[from].push_back(i);
+        }
+
+        for (const auto& [from, pair_ids] : pairs_by_origin) {
+            std::vector<graph::VertexId> group_targets;
+            group_targets.reserve(pair_ids.size());
+            for (const size_t pair_id : pair_ids) {
+                group_targets.push_back(targets[pair_id]);
+            }
+            auto group_routes = ComputeRoutes(from, group_targets);
+            for (size_t k = 0; k < pair_ids.size(); ++k) {
+                routes[pair_ids[k]] = std::move(group_routes[k]);
+                if (route_cache_) {
+                    route_cache_->Put(GetRouteCacheKey(from, group_targets[k]), routes[pair_ids[k]]);
+                }
+            }
+        }
+        return routes;
+    }
+
+    graph::VertexId TransportRouter::GetStopVertex(std::string_view stop_name) const {
+        const auto it = stop_ids_.find(stop_name);
+        if (it == stop_ids_.end()) {
+            throw std::out_of_range("unknown stop: " + std::string(stop_name));
+        }
+        return it->second;
+    }
+
+    std::vector<ReachableStop> TransportRouter::FindReachableStops(const std::string_view stop_from, double max_time) const {
+        const graph::VertexId from = GetStopVertex(stop_from);
+        std::vector<ReachableStop> reachable_stops;
+        if (raptor_router_) {
+            const std::vector<double> times = raptor_router_->GetArrivalTimes(static_cast<uint32_t>(from / 2), max_time);
+            for (size_t stop = 0; stop < times.size(); ++stop) {
+                if (times[stop] <= max_time) {
+                    reachable_stops.push_back({ stop_names_[stop * 2], times[stop] });
+                }
+            }
+        }
+        else {
+            for (const auto& [vertex, time] : graph::FindVerticesWithin(graph_, from, max_time)) {
+                if (!stop_names_[vertex].empty()) {
+                    reachable_stops.push_back({ stop_names_[vertex], time });
+                }
+            }
+        }
+        // Одно и то же время, набранное по разным путям, расходится в последних битах,
+        // поэтому для порядка время округляется до миллионных долей минуты
+        std::sort(reachable_stops.begin(), reachable_stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+            return std::make_tuple(std::llround(lhs.time * 1e6), lhs.stop_name)
+                < std::make_tuple(std::llround(rhs.time * 1e6), rhs.stop_name);
+        });
+        return reachable_stops;
+    }
+
+    std::vector<double> TransportRouter::FindTravelTimes(const std::vector<std::string_view>& origins, const std::vector<std::string_view>& destinations) const {
+        std::vector<graph::VertexId> from_ids;
+        std::vector<graph::VertexId> to_ids;
+        from_ids.reserve(origins.size());
+        to_ids.reserve(destinations.size());
+        for (const std::string_view stop : origins) {
+            from_ids.push_back(GetStopVertex(stop));
+        }
+        for (const std::string_view stop : destinations) {
+            to_ids.push_back(GetStopVertex(stop));
+        }
+
+        constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+        const size_t columns_count = to_ids.size();
+        std::vector<double> times(from_ids.size() * columns_count, INFINITE_TIME);
+        // Каждая задача пишет только в свою строку общего буфера
+        auto fill_row = [&](size_t row) {
+            double* row_times = times.data() + row * columns_count;
+            const graph::VertexId from = from_ids[row];
+            if (router_) {
+                for (size_t column = 0; column < columns_count; ++column) {
+                    row_times[column] = router_->GetRouteWeight(from, to_ids[column]).value_or(INFINITE_TIME);
+                }
+            }
+            else if (raptor_router_) {
+                const std::vector<double> arrival_times = raptor_router_->GetArrivalTimes(static_cast<uint32_t>(from / 2), INFINITE_TIME);
+                for (size_t column = 0; column < columns_count; ++column) {
+                    row_times[column] = arrival_times[to_ids[column] / 2];
+                }
+            }
+            else {
+                // Нужны только веса, поэтому пути не восстанавливаются
+                static thread_local std::vector<std::optional<double>> weights;
+                if (dijkstra_router_) {
+                    dijkstra_router_->GetRouteWeights(from, to_ids, weights);
+                }
+                else if (hierarchy_) {
+                    hierarchy_->GetRouteWeights(from, to_ids, weights);
+                }
+                else {
+                    alt_router_->GetRouteWeights(from, to_ids, weights);
+                }
+                for (size_t column = 0; column < columns_count; ++column) {
+                    row_times[column] = weights[column].value_or(INFINITE_TIME);
+                }
+            }
+        };
+
+        std::lock_guard lock(thread_pool_mutex_);
+        thread_pool_.ParallelFor(from_ids.size(), fill_row);
+        return times;
+    }
+
+    std::vector<std::optional<TransportRouter::RouteView>> TransportRouter::FindRouteViews(const std::vector<std::pair<std::string_view, std::string_view>>& stop_pairs) const {
+        static thread_local graph::RouteBatch<double> batch;
+        static thread_local std::vector<graph::Edge<double>> items;
+        items.clear();
+        // Границы пунктов каждого маршрута в items; буфер растёт, поэтому указатели берутся в конце
+        std::vector<std::pair<size_t, size_t>> bounds(stop_pairs.size());
+        std::vector<bool> is_found(stop_pairs.size(), false);
+
+        if (route_cache_ || raptor_router_) {
+            const std::vector<Route> routes = FindRoutes(stop_pairs);
+            for (size_t i = 0; i < routes.size(); ++i) {
+                if (routes[i]) {
+                    bounds[i] = { items.size(), items.size() + routes[i]->size() };
+                    items.insert(items.end(), routes[i]->begin(), routes[i]->end());
+                    is_found[i] = true;
+                }
+            }
+        }
+        else {
+            // Дейкстра и иерархия решают группу с общим началом одним поиском
+            std::map<graph::VertexId, std::vector<size_t>> pairs_by_origin;
+            std::vector<graph::VertexId> targets(stop_pairs.size());
+            for (size_t i = 0; i < stop_pairs.size(); ++i) {
+                targets[i] = GetStopVertex(stop_pairs[i].second);
+                pairs_by_origin[GetStopVertex(stop_pairs[i].first)].push_back(i);
+            }
+            std::vector<graph::VertexId> group_targets;
+            for (const auto& [from, pair_ids] : pairs_by_origin) {
+                group_targets.clear();
+                for (const size_t pair_id : pair_ids) {
+                    group_targets.push_back(targets[pair_id]);
+                }
+                BuildRoutes(from, group_targets, batch);
+                for (size_t k = 0; k < pair_ids.size(); ++k) {
+                    if (batch.weights[k]) {
+                        const size_t begin = items.size();
+                        AppendRouteItems(batch.GetEdges(k), items);
+                        bounds[pair_ids[k]] = { begin, items.size() };
+                        is_found[pair_ids[k]] = true;
+                    }
+                }
+            }
+        }
+
+        std::vector<std::optional<RouteView>> views(stop_pairs.size());
+        for (size_t i = 0; i < stop_pairs.size(); ++i) {
+            if (is_found[i]) {
+                views[i].emplace(items.data() + bounds[i].first, items.data() + bounds[i].second);
+            }
+        }
+        return views;
+    }
+
+    TransportRouter::Route TransportRouter::ComputeRoute(graph::VertexId from, graph::VertexId to) const {
+        if (raptor_router_) {
+            return MakeRoute(raptor_router_->BuildRoute(static_cast<uint32_t>(from / 2), static_cast<uint32_t>(to / 2)));
+        }
+        return MakeRoute(BuildRoute(from, to));
+    }
+
+    std::vector<TransportRouter::Route> TransportRouter::ComputeRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const {
+        std::vector<Route> routes;
+        routes.reserve(targets.size());
+        if (raptor_router_) {
+            for (const graph::VertexId to : targets) {
+                routes.push_back(ComputeRoute(from, to));
+            }
+            return routes;
+        }
+        for (const auto& routing : BuildRoutes(from, targets)) {
+            routes.push_back(MakeRoute(routing));
+        }
+        return routes;
+    }
+
+    TransportRouter::Route TransportRouter::MakeRoute(const std::optional<std::vector<RaptorRouter::Leg>>& legs) const {
+        if (!legs) {
+            return std::nullopt;
+        }
+        std::vector<graph::Edge<double>> route;
+        route.reserve(legs.value().size() * 2);
+        for (const auto& leg : legs.value()) {
+            const graph::VertexId wait_vertex = static_cast<graph::VertexId>(leg.board_stop) * 2;
+            graph::Edge<double> wait_edge = GetWaitEdge(wait_vertex);
+            wait_edge.weight = leg.wait_time;
+            route.push_back(wait_edge);
+            route.push_back({ leg.name_id,
+                              leg.span_count,
+                              wait_vertex + 1,
+                              static_cast<graph::VertexId>(leg.alight_stop) * 2,
+                              leg.ride_time });
+        }
+        return route;
+    }
+
+    TransportRouter::Route TransportRouter::MakeRoute(const std::optional<graph::Router<double>::RouteInfo>& routing) const {
         if (!routing) {
             return std::nullopt;
         }
-        Route route_by_id;
         std::vector<graph::Edge<double>> route;
-        for (const auto id : routing.value().edges) {
-            route.push_back(graph_.GetEdge(id));
+        const std::vector<graph::EdgeId>& edges = routing.value().edges;
+        AppendRouteItems({ edges.data(), edges.data() + edges.size() }, route);
+        return route;
+    }
+
+    void TransportRouter::AppendRouteItems(ranges::Range<const graph::EdgeId*> edges, std::vector<graph::Edge<double>>& route) const {
+        const size_t edges_count = edges.end() - edges.begin();
+        if (IsSingleVertexGraph()) {
+            // Ожидание входит в вес ребра поездки, пункт Wait восстанавливается по петле остановки
+            route.reserve(route.size() + edges_count * 2);
+            for (const auto id : edges) {
+                graph::Edge<double> edge = graph_.GetEdge(id);
+                route.push_back(GetWaitEdge(edge.from));
+                edge.weight = ride_times_[id];
+                route.push_back(edge);
+            }
+            return;
+        }
+        route.reserve(route.size() + edges_count);
+        if (!IsCompactGraph()) {
+            for (const auto id : edges) {
+                route.push_back(graph_.GetEdge(id));
+            }
+            return;
+        }
+
+        // Подряд идущие проезды сливаются в одну поездку, время которой считается по сумме
+        // целых длин перегонов — так же, как вес ребра в полной модели
+        const size_t stops_count = stop_ids_.size();
+        const double speed = settings_.bus_velocity_ * KMH_TO_MMIN;
+        bool is_riding = false;
+        size_t ride_distance = 0;
+        for (const auto id : edges) {
+            const auto edge = graph_.GetEdge(id);
+            if (edge.from < stops_count) {
+                route.push_back(edge);
+                is_riding = false;
+            }
+            else if (edge.to < stops_count) {
+                is_riding = false;
+            }
+            else if (is_riding) {
+                ride_distance += edge.quality;
+                route.back().quality += 1;
+                route.back().to = edge.to;
+                route.back().weight = static_cast<double>(ride_distance) / speed;
+            }
+            else {
+                ride_distance = edge.quality;
+                route.push_back({ edge.name_id, 1, edge.from, edge.to, static_cast<double>(ride_distance) / speed });
+                is_riding = true;
+            }
         }
-        return route_by_id = route;
     }
 
-    void TransportRouter::SetRoutingSettings(const RoutingSettings& settings) {
-        settings_ = settings;
+    concurrency::CacheStats TransportRouter::GetRouteCacheStats() const {
+        return route_cache_ ? route_cache_->GetStats() : concurrency::CacheStats{};
     }
 
-    void TransportRouter::SetGraph(Graph&& graph) {
-        graph_ = std::move(graph);
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+    void TransportRouter::IndexStopVertices() {
+        stop_names_.assign(graph_.GetVertexCount(), {});
+        for (const auto& [stop_name, vertex] : stop_ids_) {
+            stop_names_[vertex] = stop_name;
+        }
     }
 
-    void TransportRouter::SetStopByIds(StopById stop_ids) {
-        stop_ids_ = std::move(stop_ids);
+    void TransportRouter::InitRouteCache() {
+        route_cache_.reset();
+        if (settings_.route_cache_capacity_ > 0) {
+            route_cache_ = std::make_unique<concurrency::ShardedLruCache<uint64_t, Route>>(settings_.route_cache_capacity_);
+        }
     }
 
+    std::string_view TransportRouter::GetEdgeName(const graph::Edge<double>& edge) const {
+        return graph_.GetName(edge.name_id);
+    }
+
+    void TransportRouter::AddStopToGraph(const Stop& stop, graph::VertexId vertex_id, Graph& stops_graph) {
+        // В графе с одной вершиной на остановку ребро ожидания — петля: маршрутизаторы его
+        // не используют, но оно хранит имя остановки для восстановления пунктов Wait
+        stops_graph.AddEdge({
+                stops_graph.AddName(std::string(stop.name)),
+                0,
+                vertex_id,
+                IsSingleVertexGraph() ? vertex_id : vertex_id + 1,
+                static_cast<double>(settings_.bus_wait_time_)
+            });
+        if (IsSingleVertexGraph()) {
+            ride_times_.push_back(0.0);
+        }
+    }
+
+    void TransportRouter::AddBusEdge(graph::Edge<double> edge, Graph& stops_graph) {
+        if (IsSingleVertexGraph()) {
+            ride_times_.push_back(edge.weight);
+            edge.weight += static_cast<double>(settings_.bus_wait_time_);
+        }
+        stops_graph.AddEdge(edge);
+    }
+
+    std::vector<graph::EdgeId> TransportRouter::FreezeGraph(Graph& stops_graph) {
+        std::vector<graph::EdgeId> new_edge_ids = stops_graph.Freeze();
+        if (!ride_times_.empty()) {
+            std::vector<double> ride_times(ride_times_.size());
+            for (graph::EdgeId edge_id = 0; edge_id < new_edge_ids.size(); ++edge_id) {
+                ride_times[new_edge_ids[edge_id]] = ride_times_[edge_id];
+            }
+            ride_times_ = std::move(ride_times);
+        }
+        return new_edge_ids;
+    }
+
+    graph::Edge<double> TransportRouter::GetWaitEdge(graph::VertexId stop_vertex) const {
+        // Ребро ожидания добавляется раньше рёбер автобусов, поэтому оно первое среди исходящих
+        return graph_.GetEdge(*graph_.GetIncidentEdges(stop_vertex).begin());
+    }
+
+    std::vector<const Stop*> TransportRouter::OrderStops(Catalogue::StopIdRange stop_ids) const {
+        std::vector<const Stop*> ordered_stops;
+        ordered_stops.reserve(std::distance(stop_ids.begin(), stop_ids.end()));
+        for (const StopId stop_id : stop_ids) {
+            ordered_stops.push_back(catalogue_.GetStop(stop_id));
+        }
+        if (settings_.vertex_order_ != VertexOrder::HILBERT || ordered_stops.empty()) {
+            return ordered_stops;
+        }
+
+        geo::Coordinates min = ordered_stops.front()->coordinates;
+        geo::Coordinates max = min;
+        for (const Stop* stop : ordered_stops) {
+            min = { std::min(min.lat, stop->coordinates.lat), std::min(min.lng, stop->coordinates.lng) };
+            max = { std::max(max.lat, stop->coordinates.lat), std::max(max.lng, stop->coordinates.lng) };
+        }
+        std::vector<std::pair<uint64_t, const Stop*>> keyed_stops;
+        keyed_stops.reserve(ordered_stops.size());
+        for (const Stop* stop : ordered_stops) {
+            keyed_stops.emplace_back(geo::ComputeHilbertIndex(stop->coordinates, min, max), stop);
+        }
+        // Остановки в одной клетке сетки остаются в порядке названий: сортировка устойчивая
+        std::stable_sort(keyed_stops.begin(), keyed_stops.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        for (size_t i = 0; i < keyed_stops.size(); ++i) {
+            ordered_stops[i] = keyed_stops[i].second;
+        }
+        return ordered_stops;
+    }
 
-    void TransportRouter::FillGraphByStop(const std::map<std::string_view, const Stop*>& stops, Graph& stops_graph) {
-        std::map<std::string, graph::VertexId> stop_ids;
+    void TransportRouter::FillGraphByStop(const std::vector<const Stop*>& stops, Graph& stops_graph) {
+        StopById stop_ids;
         graph::VertexId vertex_id = 0;
 
-        for (const auto& [stop_name, stop_info] : stops) {
-            stop_ids[stop_info->name] = vertex_id;
-            stops_graph.AddEdge({
-                    stop_info->name,
-                    0,
-                    vertex_id,
-                    ++vertex_id,
-                    static_cast<double>(settings_.bus_wait_time_)
-                });
-            ++vertex_id;
+        for (const Stop* stop_info : stops) {
+            stop_ids[std::string(stop_info->name)] = vertex_id;
+            AddStopToGraph(*stop_info, vertex_id, stops_graph);
+            vertex_id += IsSingleVertexGraph() ? 1 : 2;
         }
         stop_ids_ = std::move(stop_ids);
     }
 
-    void TransportRouter::FillGraphByBus(const std::map<std::string_view, const Bus*>& buses, Graph& stops_graph) {
-        for_each(
-            buses.begin(),
-            buses.end(),
-            [&stops_graph, this](const auto& item) {
-                const auto& bus_info = item.second;
-                const auto& stops = bus_info->stops;
-                size_t stops_count = stops.size();
-                for (size_t i = 0; i < stops_count; ++i) {
-                    for (size_t j = i + 1; j < stops_count; ++j) {
-                        const Stop* stop_from = stops[i];
-                        const Stop* stop_to = stops[j];
-                        int dist_sum = 0;
-                        int dist_sum_inverse = 0;
-                        for (size_t k = i + 1; k <= j; ++k) {
-                            dist_sum += catalogue_.GetDistance(stops[k - 1], stops[k]);
-                            dist_sum_inverse += catalogue_.GetDistance(stops[k], stops[k - 1]);
-                        }
-                        stops_graph.AddEdge({ bus_info->number,
-                                              j - i,
-                                              stop_ids_.at(stop_from->name) + 1,
-                                              stop_ids_.at(stop_to->name),
-                                              static_cast<double>(dist_sum) / (settings_.bus_velocity_ * KMH_TO_MMIN) });
-
-                        if (!bus_info->is_circle) {
-                            stops_graph.AddEdge({ bus_info->number,
-                                                  j - i,
-                                                  stop_ids_.at(stop_to->name) + 1,
-                                                  stop_ids_.at(stop_from->name),
-                                                  static_cast<double>(dist_sum_inverse) / (settings_.bus_velocity_ * KMH_TO_MMIN) });
-                        }
+    std::vector<graph::Edge<double>> TransportRouter::MakeBusEdges(const Bus& bus, graph::NameId name_id) const {
+        const auto& stops = bus.stops;
+        const size_t stops_count = stops.size();
+        std::vector<graph::VertexId> vertex_ids(stops_count);
+        // Длины отрезков от первой остановки в прямом и обратном направлении
+        std::vector<int> dist_prefix(stops_count, 0);
+        std::vector<int> dist_prefix_inverse(stops_count, 0);
+        const Stop* prev_stop = nullptr;
+        for (size_t k = 0; k < stops_count; ++k) {
+            const Stop* stop = catalogue_.GetStop(stops[k]);
+            vertex_ids[k] = GetStopVertex(stop->name);
+            if (k > 0) {
+                dist_prefix[k] = dist_prefix[k - 1] + catalogue_.GetDistance(prev_stop, stop);
+                dist_prefix_inverse[k] = dist_prefix_inverse[k - 1] + catalogue_.GetDistance(stop, prev_stop);
+            }
+            prev_stop = stop;
+        }
+
+        // В графе с одной вершиной на остановку поездка начинается прямо в ней
+        const graph::VertexId board_shift = IsSingleVertexGraph() ? 0 : 1;
+        std::vector<graph::Edge<double>> edges;
+        if (stops_count > 1) {
+            edges.reserve(stops_count * (stops_count - 1) / (bus.is_circle ? 2 : 1));
+        }
+        for (size_t i = 0; i < stops_count; ++i) {
+            for (size_t j = i + 1; j < stops_count; ++j) {
+                const int dist_sum = dist_prefix[j] - dist_prefix[i];
+                edges.push_back({ name_id,
+                                  j - i,
+                                  vertex_ids[i] + board_shift,
+                                  vertex_ids[j],
+                                  static_cast<double>(dist_sum) / (settings_.bus_velocity_ * KMH_TO_MMIN) });
+
+                if (!bus.is_circle) {
+                    const int dist_sum_inverse = dist_prefix_inverse[j] - dist_prefix_inverse[i];
+                    edges.push_back({ name_id,
+                                      j - i,
+                                      vertex_ids[j] + board_shift,
+                                      vertex_ids[i],
+                                      static_cast<double>(dist_sum_inverse) / (settings_.bus_velocity_ * KMH_TO_MMIN) });
+                }
+            }
+        }
+        return edges;
+    }
+
+    void TransportRouter::FillGraphByBus(Catalogue::BusIdRange bus_ids, Graph& stops_graph) {
+        std::vector<const Bus*> bus_infos;
+        std::vector<graph::NameId> name_ids;
+        bus_infos.reserve(std::distance(bus_ids.begin(), bus_ids.end()));
+        name_ids.reserve(bus_infos.capacity());
+        for (const BusId bus_id : bus_ids) {
+            const Bus* bus_info = catalogue_.GetBus(bus_id);
+            bus_infos.push_back(bus_info);
+            name_ids.push_back(stops_graph.AddName(std::string(bus_info->number)));
+        }
+
+        // Рёбра автобусов строятся параллельно в отдельные буферы и добавляются
+        // в граф в порядке номеров автобусов, так что граф не зависит от числа потоков
+        std::vector<std::vector<graph::Edge<double>>> bus_edges(bus_infos.size());
+        thread_pool_.ParallelFor(bus_infos.size(), [&](size_t index) {
+            bus_edges[index] = MakeBusEdges(*bus_infos[index], name_ids[index]);
+        });
+        for (auto& edges : bus_edges) {
+            for (const auto& edge : edges) {
+                AddBusEdge(edge, stops_graph);
+            }
+            std::vector<graph::Edge<double>>().swap(edges);
+        }
+    }
+
+    bool TransportRouter::IsSingleVertexGraph() const {
+        return settings_.graph_model_ == GraphModel::SINGLE_VERTEX && settings_.router_type_ != RouterType::RAPTOR;
+    }
+
+    bool TransportRouter::IsCompactGraph() const {
+        // RAPTOR строит граф только из остановок и всегда в полной раскладке
+        return settings_.graph_model_ == GraphModel::COMPACT && settings_.router_type_ != RouterType::RAPTOR;
+    }
+
+    void TransportRouter::BuildCompactGraph(const std::vector<const Stop*>& stops, Catalogue::BusIdRange bus_ids) {
+        // Вершины остановок занимают номера [0, stops.size()), за ними идут вершины проезда.
+        // Посадка — ребро ожидания от остановки к вершине проезда, проезд перегона — ребро
+        // с длиной перегона в quality, высадка — ребро нулевого веса обратно к остановке.
+        Graph stops_graph(stops.size());
+        StopById stop_ids;
+        std::vector<graph::NameId> stop_name_ids;
+        stop_name_ids.reserve(stops.size());
+        for (const Stop* stop_info : stops) {
+            stop_ids[std::string(stop_info->name)] = stop_name_ids.size();
+            stop_name_ids.push_back(stops_graph.AddName(std::string(stop_info->name)));
+        }
+        stop_ids_ = std::move(stop_ids);
+
+        const double speed = settings_.bus_velocity_ * KMH_TO_MMIN;
+        for (const BusId bus_id : bus_ids) {
+            const Bus* bus_info = catalogue_.GetBus(bus_id);
+            const graph::NameId name_id = stops_graph.AddName(std::string(bus_info->number));
+            for (const auto& line : GetBusLines(*bus_info)) {
+                const graph::VertexId first_riding_vertex = stops_graph.GetVertexCount();
+                stops_graph.AddVertices(line.stops.size());
+                for (size_t k = 0; k < line.stops.size(); ++k) {
+                    const graph::VertexId stop_vertex = GetStopVertex(line.stops[k]->name);
+                    const graph::VertexId riding_vertex = first_riding_vertex + k;
+                    if (k + 1 < line.stops.size()) {
+                        const int distance = line.distances[k + 1] - line.distances[k];
+                        stops_graph.AddEdge({ stop_name_ids[stop_vertex], 0, stop_vertex, riding_vertex,
+                                              static_cast<double>(settings_.bus_wait_time_) });
+                        stops_graph.AddEdge({ name_id, static_cast<size_t>(distance), riding_vertex, riding_vertex + 1,
+                                              static_cast<double>(distance) / speed });
+                    }
+                    if (k > 0) {
+                        stops_graph.AddEdge({ name_id, 0, riding_vertex, stop_vertex, 0.0 });
                     }
                 }
-            });
+            }
+        }
+        stops_graph.Freeze();
+        graph_ = std::move(stops_graph);
     }
 
     void TransportRouter::BuildGraph() {
-        const auto& all_stops = catalogue_.GetSortedAllStops();
-        const auto& all_buses = catalogue_.GetSortedAllBuses();
-        Graph stops_graph(all_stops.size() * 2);
+        const std::vector<const Stop*> all_stops = OrderStops(catalogue_.GetSortedStopIds());
+        const Catalogue::BusIdRange all_buses = catalogue_.GetSortedBusIds();
+        ride_times_.clear();
+        if (IsCompactGraph()) {
+            BuildCompactGraph(all_stops, all_buses);
+            return;
+        }
+        Graph stops_graph(all_stops.size() * (IsSingleVertexGraph() ? 1 : 2));
         FillGraphByStop(all_stops, stops_graph);
-        FillGraphByBus(all_buses, stops_graph);
+        if (settings_.router_type_ == RouterType::RAPTOR) {
+            // RAPTOR идёт по линиям каталога, рёбра автобусов ему не нужны
+            for (const BusId bus_id : all_buses) {
+                stops_graph.AddName(std::string(catalogue_.GetBus(bus_id)->number));
+            }
+        }
+        else {
+            FillGraphByBus(all_buses, stops_graph);
+        }
+        FreezeGraph(stops_graph);
         graph_ = std::move(stops_graph);
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+    }
+
+    void TransportRouter::AddStopsAndBuses(const std::vector<const Stop*>& stops, const std::vector<const Bus*>& buses) {
+        if (IsCompactGraph()) {
+            // Вершины проезда идут сразу за вершинами остановок, новые остановки
+            // между ними не вписать, поэтому компактный граф строится заново
+            BuildGraph();
+            BuildRouter();
+            IndexStopVertices();
+            InitRouteCache();
+            return;
+        }
+        const size_t old_edge_count = graph_.GetEdgeCount();
+        const size_t vertices_per_stop = IsSingleVertexGraph() ? 1 : 2;
+        graph::VertexId vertex_id = graph_.GetVertexCount();
+        graph_.AddVertices(stops.size() * vertices_per_stop);
+        for (const Stop* stop : stops) {
+            stop_ids_[std::string(stop->name)] = vertex_id;
+            AddStopToGraph(*stop, vertex_id, graph_);
+            vertex_id += vertices_per_stop;
+        }
+        for (const Bus* bus : buses) {
+            const graph::NameId name_id = graph_.AddName(std::string(bus->number));
+            if (settings_.router_type_ == RouterType::RAPTOR) {
+                continue;
+            }
+            for (const auto& edge : MakeBusEdges(*bus, name_id)) {
+                AddBusEdge(edge, graph_);
+            }
+        }
+        const std::vector<graph::EdgeId> new_edge_ids = FreezeGraph(graph_);
+
+        if (router_) {
+            router_->AddEdges(new_edge_ids, old_edge_count);
+        }
+        else {
+            BuildRouter();
+        }
+        IndexStopVertices();
+        InitRouteCache();
+    }
+
+    void TransportRouter::BuildRouter(RouterData router_data) {
+        router_.reset();
+        dijkstra_router_.reset();
+        hierarchy_.reset();
+        alt_router_.reset();
+        raptor_router_.reset();
+        switch (settings_.router_type_) {
+        case RouterType::ALL_PAIRS:
+            router_ = router_data.routes_table.weights.empty()
+                ? std::make_unique<graph::Router<double>>(graph_, settings_.threads_count_)
+                : std::make_unique<graph::Router<double>>(graph_, std::move(router_data.routes_table));
+            break;
+        case RouterType::DIJKSTRA:
+            dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+            break;
+        case RouterType::CONTRACTION_HIERARCHY:
+            hierarchy_ = router_data.hierarchy_index.ranks.empty()
+                ? std::make_unique<Hierarchy>(graph_)
+                : std::make_unique<Hierarchy>(graph_, std::move(router_data.hierarchy_index));
+            break;
+        case RouterType::RAPTOR:
+            raptor_router_ = MakeRaptorRouter();
+            break;
+        case RouterType::ALT:
+            alt_router_ = router_data.landmarks.vertices.empty()
+                ? std::make_unique<AltRouter>(graph_, settings_.landmarks_count_)
+                : std::make_unique<AltRouter>(graph_, std::move(router_data.landmarks));
+            break;
+        }
+    }
+
+    std::vector<TransportRouter::BusLine> TransportRouter::GetBusLines(const Bus& bus) const {
+        std::vector<const Stop*> stops(bus.stops.size());
+        for (size_t k = 0; k < stops.size(); ++k) {
+            stops[k] = catalogue_.GetStop(bus.stops[k]);
+        }
+        BusLine line{ stops, std::vector<int>(stops.size(), 0) };
+        for (size_t k = 1; k < stops.size(); ++k) {
+            line.distances[k] = line.distances[k - 1] + catalogue_.GetDistance(stops[k - 1], stops[k]);
+        }
+        if (bus.is_circle) {
+            return { std::move(line) };
+        }
+        // Обратное направление: те же остановки в обратном порядке со своими расстояниями
+        BusLine reverse_line{ std::vector<const Stop*>(stops.rbegin(), stops.rend()), std::vector<int>(stops.size(), 0) };
+        for (size_t k = 1; k < stops.size(); ++k) {
+            reverse_line.distances[k] = reverse_line.distances[k - 1]
+                + catalogue_.GetDistance(reverse_line.stops[k - 1], reverse_line.stops[k]);
+        }
+        return { std::move(line), std::move(reverse_line) };
+    }
+
+    std::unique_ptr<RaptorRouter> TransportRouter::MakeRaptorRouter() const {
+        std::unordered_map<std::string_view, graph::NameId> name_ids;
+        for (graph::NameId name_id = 0; name_id < graph_.GetNameCount(); ++name_id) {
+            name_ids.emplace(graph_.GetName(name_id), name_id);
+        }
+
+        std::vector<RaptorRouter::Line> lines;
+        for (const BusId bus_id : catalogue_.GetSortedBusIds()) {
+            const Bus* bus_info = catalogue_.GetBus(bus_id);
+            const auto headway = settings_.bus_headways_.find(std::string(bus_info->number));
+            const double wait_time = headway != settings_.bus_headways_.end()
+                ? headway->second
+                : static_cast<double>(settings_.bus_wait_time_);
+
+            for (auto& bus_line : GetBusLines(*bus_info)) {
+                RaptorRouter::Line line{ name_ids.at(bus_info->number), wait_time, {}, std::move(bus_line.distances) };
+                for (const Stop* stop : bus_line.stops) {
+                    line.stops.push_back(static_cast<uint32_t>(GetStopVertex(stop->name) / 2));
+                }
+                lines.push_back(std::move(line));
+            }
+        }
+        return std::make_unique<RaptorRouter>(stop_ids_.size(), settings_.bus_velocity_ * KMH_TO_MMIN, lines);
+    }
+
+    std::optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to) const {
+        if (dijkstra_router_) {
+            return dijkstra_router_->BuildRoute(from, to);
+        }
+        if (hierarchy_) {
+            return hierarchy_->BuildRoute(from, to);
+        }
+        if (alt_router_) {
+            return alt_router_->BuildRoute(from, to);
+        }
+        return router_->BuildRoute(from, to);
     }
     
+    std::optional<double> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to, std::vector<graph::EdgeId>& edges) const {
+        if (dijkstra_router_) {
+            return dijkstra_router_->BuildRoute(from, to, edges);
+        }
+        if (hierarchy_) {
+            return hierarchy_->BuildRoute(from, to, edges);
+        }
+        if (alt_router_) {
+            return alt_router_->BuildRoute(from, to, edges);
+        }
+        return router_->BuildRoute(from, to, edges);
+    }
+
+    std::vector<std::optional<graph::Router<double>::RouteInfo>> TransportRouter::BuildRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets) const {
+        graph::RouteBatch<double> batch;
+        BuildRoutes(from, targets, batch);
+        std::vector<std::optional<graph::Router<double>::RouteInfo>> routes;
+        routes.reserve(targets.size());
+        for (size_t k = 0; k < targets.size(); ++k) {
+            routes.push_back(batch.GetRoute(k));
+        }
+        return routes;
+    }
+
+    void TransportRouter::BuildRoutes(graph::VertexId from, const std::vector<graph::VertexId>& targets, graph::RouteBatch<double>& batch) const {
+        if (dijkstra_router_) {
+            dijkstra_router_->BuildRoutes(from, targets, batch);
+            return;
+        }
+        if (hierarchy_) {
+            hierarchy_->BuildRoutes(from, targets, batch);
+            return;
+        }
+        // Таблица всех пар уже хранит ответы, группировка ей не нужна; поиск ALT
+        // направлен к одной цели, поэтому каждая пара ищется отдельно
+        static thread_local std::vector<graph::EdgeId> edges;
+        batch.Clear();
+        for (const graph::VertexId to : targets) {
+            const std::optional<double> weight = BuildRoute(from, to, edges);
+            batch.edges.insert(batch.edges.end(), edges.begin(), edges.end());
+            batch.AddRoute(weight);
+        }
+    }
+
     const RoutingSettings& GetRouteData::GetRoutingSettings(const transport::TransportRouter& router) const {
         return router.settings_;
     }
@@ -107,4 +739,24 @@ namespace transport {
         return router.graph_;
     }
 
+    const graph::Router<double>* GetRouteData::GetRouter(const transport::TransportRouter& router) const
+    {
+        return router.router_.get();
+    }
+
+    const std::vector<double>& GetRouteData::GetRideTimes(const transport::TransportRouter& router) const
+    {
+        return router.ride_times_;
+    }
+
+    const TransportRouter::Hierarchy* GetRouteData::GetHierarchy(const transport::TransportRouter& router) const
+    {
+        return router.hierarchy_.get();
+    }
+
+    const TransportRouter::AltRouter* GetRouteData::GetAltRouter(const transport::TransportRouter& router) const
+    {
+        return router.alt_router_.get();
+    }
+
 }
\ No newline at end of file